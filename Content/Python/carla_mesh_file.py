@@ -0,0 +1,144 @@
+# Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+# de Barcelona (UAB).
+#
+# This work is licensed under the terms of the MIT license.
+# For a copy, see <https://opensource.org/licenses/MIT>.
+
+"""Writes mesh files for UMapGenFunctionLibrary::CreateMeshesFromFile.
+
+The layout is documented in Public/Generation/ProceduralMeshFile.h. The
+plugin memory maps the file and builds the meshes straight from it, so this
+is the fast way to hand many meshes over to Unreal::
+
+    with MeshFileWriter(path) as writer:
+        for road in roads:
+            writer.add_mesh(road.name, road.positions, road.triangles, uv0=road.uvs)
+
+Positions are in centimeters. Every channel but positions and triangles is
+optional; missing normals and tangents are computed by the plugin.
+"""
+
+import struct
+
+import numpy as np
+
+MAGIC = b"CMGM"
+VERSION = 1
+BLOCK_ALIGNMENT = 16
+
+# Characters Unreal does not allow in asset or package names.
+_INVALID_NAME_CHARACTERS = set("\"' ,/.:|&!~\n\r\t@#(){}[]=;^%$`\\*?<>")
+
+_HEADER = struct.Struct("<4sIIIQQ")
+_ENTRY = struct.Struct("<QIIQIIQQQQQQQQ")
+assert _HEADER.size == 32 and _ENTRY.size == 96
+
+
+def _octahedral_snorm16(vectors):
+    """Packs unit vectors as in FProceduralCompactMesh::PackNormal."""
+    vectors = np.asarray(vectors, dtype=np.float32).reshape(-1, 3)
+    l1 = np.abs(vectors).sum(axis=1, keepdims=True)
+    encoded = np.divide(vectors[:, :2], l1, out=np.zeros_like(vectors[:, :2]), where=l1 > 1e-8)
+    lower = vectors[:, 2] < 0.0
+    signs = np.where(encoded >= 0.0, 1.0, -1.0)
+    folded = (1.0 - np.abs(encoded[:, ::-1])) * signs
+    encoded[lower] = folded[lower]
+    snorm = np.rint(np.clip(encoded, -1.0, 1.0) * 32767.0).astype(np.int16).view(np.uint16).astype(np.uint32)
+    return snorm[:, 0] | (snorm[:, 1] << 16)
+
+
+def pack_normals(normals):
+    return _octahedral_snorm16(normals)
+
+
+def pack_tangents(tangents, flip_tangent_y):
+    """Packs as in FProceduralCompactMesh::PackTangent."""
+    flip = np.asarray(flip_tangent_y, dtype=bool).reshape(-1).astype(np.uint32)
+    return (_octahedral_snorm16(tangents) & ~np.uint32(1)) | flip
+
+
+class MeshFileWriter:
+    """Collects meshes and writes them as one file on close."""
+
+    def __init__(self, path):
+        self._path = path
+        self._meshes = []
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if exc_type is None:
+            self.close()
+
+    def add_mesh(self, name, positions, triangles, normals=None, tangents=None,
+                 flip_tangent_y=None, uv0=None, colors=None, material_path=""):
+        """Adds a mesh.
+
+        positions: (N, 3) floats. triangles: (M * 3) vertex indices.
+        normals, tangents: (N, 3) unit vectors. flip_tangent_y: N bools.
+        uv0: (N, 2) floats. colors: (N, 4) uint8 RGBA in sRGB.
+        name: the asset name, without spaces, dots, slashes or the other
+        characters Unreal does not allow in asset names.
+        material_path: e.g. "/Game/Materials/M_Road.M_Road", or empty for the
+        default material passed to CreateMeshesFromFile.
+        """
+        if not name or _INVALID_NAME_CHARACTERS.intersection(name):
+            raise ValueError(f"{name!r} is not a valid asset name")
+        positions = np.ascontiguousarray(positions, dtype="<f4").reshape(-1, 3)
+        count = len(positions)
+        blocks = {
+            "positions": positions,
+            "triangles": np.ascontiguousarray(triangles, dtype="<i4").reshape(-1),
+        }
+        if normals is not None:
+            blocks["normals"] = pack_normals(normals).astype("<u4")
+        if tangents is not None:
+            flip = np.zeros(count, dtype=bool) if flip_tangent_y is None else flip_tangent_y
+            blocks["tangents"] = pack_tangents(tangents, flip).astype("<u4")
+        if uv0 is not None:
+            blocks["uv0"] = np.ascontiguousarray(uv0, dtype="<f2").reshape(-1, 2)
+        if colors is not None:
+            # FColor is stored as BGRA.
+            blocks["colors"] = np.ascontiguousarray(np.asarray(colors, dtype=np.uint8).reshape(-1, 4)[:, [2, 1, 0, 3]])
+
+        if len(blocks["triangles"]) % 3 != 0:
+            raise ValueError(f"{name}: the triangle index count is not a multiple of 3")
+        for channel, block in blocks.items():
+            if channel != "triangles" and len(block) != count:
+                raise ValueError(f"{name}: {channel} has {len(block)} entries for {count} vertices")
+        self._meshes.append((name.encode("utf-8"), material_path.encode("utf-8"), count, blocks))
+
+    def close(self):
+        with open(self._path, "wb") as file:
+            def align():
+                padding = -file.tell() % BLOCK_ALIGNMENT
+                file.write(b"\0" * padding)
+                return file.tell()
+
+            # Header and table are written last, once the offsets are known.
+            table_offset = _HEADER.size
+            file.write(b"\0" * (table_offset + _ENTRY.size * len(self._meshes)))
+
+            entries = []
+            for name, material_path, count, blocks in self._meshes:
+                name_offset = file.tell()
+                file.write(name)
+                material_offset = file.tell()
+                file.write(material_path)
+                offsets = {}
+                for channel, block in blocks.items():
+                    offsets[channel] = align()
+                    file.write(block.tobytes())
+                entries.append(_ENTRY.pack(
+                    name_offset, len(name), len(material_path), material_offset,
+                    count, len(blocks["triangles"]),
+                    offsets["positions"], offsets["triangles"],
+                    offsets.get("normals", 0), offsets.get("tangents", 0),
+                    offsets.get("uv0", 0), offsets.get("colors", 0),
+                    0, 0))
+
+            file.seek(0)
+            file.write(_HEADER.pack(MAGIC, VERSION, len(self._meshes), 0, table_offset, 0))
+            file.write(b"".join(entries))
+        self._meshes = []
@@ -62,6 +62,7 @@ public class CarlaMeshGeneration : ModuleRules
         "Slate",
         "SlateCore",
         "UnrealEd",
+        "EditorSubsystem",
         "Blutility",
         "UMG",
         "EditorScriptingUtilities",
@@ -0,0 +1,188 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Actor/ProceduralCompactMesh.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+  uint32 PackSnorm16(float Value)
+  {
+    return (uint32)(uint16)(int16)FMath::RoundToInt(FMath::Clamp(Value, -1.0f, 1.0f) * 32767.0f);
+  }
+
+  float UnpackSnorm16(uint32 Value)
+  {
+    return FMath::Max((float)(int16)(uint16)Value / 32767.0f, -1.0f);
+  }
+
+  FVector2f OctahedralEncode(const FVector3f& Vector)
+  {
+    const float L1Norm = FMath::Abs(Vector.X) + FMath::Abs(Vector.Y) + FMath::Abs(Vector.Z);
+    if (L1Norm <= UE_SMALL_NUMBER)
+    {
+      return FVector2f::ZeroVector;
+    }
+    FVector2f Result(Vector.X / L1Norm, Vector.Y / L1Norm);
+    if (Vector.Z < 0.0f)
+    {
+      // Fold the lower hemisphere over the diagonals.
+      Result = FVector2f(
+        (1.0f - FMath::Abs(Result.Y)) * (Result.X >= 0.0f ? 1.0f : -1.0f),
+        (1.0f - FMath::Abs(Result.X)) * (Result.Y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return Result;
+  }
+
+  FVector3f OctahedralDecode(const FVector2f& Encoded)
+  {
+    FVector3f Result(Encoded.X, Encoded.Y, 1.0f - FMath::Abs(Encoded.X) - FMath::Abs(Encoded.Y));
+    if (Result.Z < 0.0f)
+    {
+      Result.X = (1.0f - FMath::Abs(Encoded.Y)) * (Encoded.X >= 0.0f ? 1.0f : -1.0f);
+      Result.Y = (1.0f - FMath::Abs(Encoded.X)) * (Encoded.Y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return Result.GetSafeNormal();
+  }
+
+  template <typename T>
+  bool BitwiseEqual(const TArray<T>& A, const TArray<T>& B)
+  {
+    return A.Num() == B.Num() && FMemory::Memcmp(A.GetData(), B.GetData(), A.Num() * sizeof(T)) == 0;
+  }
+}
+
+SIZE_T FProceduralCompactMesh::GetAllocatedSize() const
+{
+  return Positions.GetAllocatedSize() + Triangles.GetAllocatedSize() + Normals.GetAllocatedSize() +
+    Tangents.GetAllocatedSize() + UV0.GetAllocatedSize() + Colors.GetAllocatedSize();
+}
+
+bool FProceduralCompactMesh::Serialize(FArchive& Ar)
+{
+  Ar << Positions;
+  Ar << Triangles;
+  Ar << Normals;
+  Ar << Tangents;
+  Ar << UV0;
+  Ar << Colors;
+  return true;
+}
+
+bool FProceduralCompactMesh::Identical(const FProceduralCompactMesh* Other, uint32 PortFlags) const
+{
+  return BitwiseEqual(Positions, Other->Positions) &&
+    BitwiseEqual(Triangles, Other->Triangles) &&
+    BitwiseEqual(Normals, Other->Normals) &&
+    BitwiseEqual(Tangents, Other->Tangents) &&
+    BitwiseEqual(UV0, Other->UV0) &&
+    BitwiseEqual(Colors, Other->Colors);
+}
+
+FProceduralCompactMesh FProceduralCompactMesh::FromCustomMesh(
+  const FProceduralCustomMesh& Mesh,
+  const TArray<FProcMeshTangent>& InTangents)
+{
+  const int32 NumVertex = Mesh.Vertices.Num();
+  const bool bHasNormals = Mesh.Normals.Num() == NumVertex;
+  const bool bHasTangents = InTangents.Num() == NumVertex;
+  const bool bHasUV0 = Mesh.UV0.Num() == NumVertex;
+  const bool bHasColors = Mesh.VertexColor.Num() == NumVertex;
+
+  FProceduralCompactMesh Result;
+  Result.Positions.SetNumUninitialized(NumVertex);
+  Result.Triangles = Mesh.Triangles;
+  Result.Normals.SetNumUninitialized(bHasNormals ? NumVertex : 0);
+  Result.Tangents.SetNumUninitialized(bHasTangents ? NumVertex : 0);
+  Result.UV0.SetNumUninitialized(bHasUV0 ? NumVertex : 0);
+  Result.Colors.SetNumUninitialized(bHasColors ? NumVertex : 0);
+
+  ParallelFor(NumVertex, [&](int32 VertexIndex)
+    {
+      Result.Positions[VertexIndex] = FVector3f(Mesh.Vertices[VertexIndex]);
+      if (bHasNormals)
+      {
+        Result.Normals[VertexIndex] = PackNormal(FVector3f(Mesh.Normals[VertexIndex]));
+      }
+      if (bHasTangents)
+      {
+        Result.Tangents[VertexIndex] = PackTangent(
+          FVector3f(InTangents[VertexIndex].TangentX), InTangents[VertexIndex].bFlipTangentY);
+      }
+      if (bHasUV0)
+      {
+        Result.UV0[VertexIndex] = FVector2DHalf(FVector2f(Mesh.UV0[VertexIndex]));
+      }
+      if (bHasColors)
+      {
+        Result.Colors[VertexIndex] = Mesh.VertexColor[VertexIndex].ToFColor(true);
+      }
+    });
+  return Result;
+}
+
+FProceduralCustomMesh FProceduralCompactMesh::ToCustomMesh(TArray<FProcMeshTangent>* OutTangents) const
+{
+  const int32 NumVertex = NumVertices();
+
+  FProceduralCustomMesh Result;
+  Result.Vertices.SetNumUninitialized(NumVertex);
+  Result.Triangles = Triangles;
+  Result.Normals.SetNumUninitialized(HasNormals() ? NumVertex : 0);
+  Result.UV0.SetNumUninitialized(HasUV0() ? NumVertex : 0);
+  Result.VertexColor.SetNumUninitialized(HasColors() ? NumVertex : 0);
+  if (OutTangents != nullptr)
+  {
+    OutTangents->SetNumUninitialized(HasTangents() ? NumVertex : 0);
+  }
+
+  ParallelFor(NumVertex, [&](int32 VertexIndex)
+    {
+      Result.Vertices[VertexIndex] = FVector(Positions[VertexIndex]);
+      if (HasNormals())
+      {
+        Result.Normals[VertexIndex] = FVector(UnpackNormal(Normals[VertexIndex]));
+      }
+      if (HasUV0())
+      {
+        Result.UV0[VertexIndex] = FVector2D(FVector2f(UV0[VertexIndex]));
+      }
+      if (HasColors())
+      {
+        Result.VertexColor[VertexIndex] = FLinearColor(Colors[VertexIndex]);
+      }
+      if (OutTangents != nullptr && HasTangents())
+      {
+        float BinormalSign = 1.0f;
+        const FVector3f TangentX = UnpackTangent(Tangents[VertexIndex], BinormalSign);
+        (*OutTangents)[VertexIndex] = FProcMeshTangent(FVector(TangentX), BinormalSign < 0.0f);
+      }
+    });
+  return Result;
+}
+
+uint32 FProceduralCompactMesh::PackNormal(const FVector3f& Normal)
+{
+  const FVector2f Encoded = OctahedralEncode(Normal);
+  return PackSnorm16(Encoded.X) | (PackSnorm16(Encoded.Y) << 16);
+}
+
+FVector3f FProceduralCompactMesh::UnpackNormal(uint32 Packed)
+{
+  return OctahedralDecode(FVector2f(UnpackSnorm16(Packed & 0xFFFF), UnpackSnorm16(Packed >> 16)));
+}
+
+uint32 FProceduralCompactMesh::PackTangent(const FVector3f& TangentX, bool bFlipTangentY)
+{
+  return (PackNormal(TangentX) & ~1u) | (bFlipTangentY ? 1u : 0u);
+}
+
+FVector3f FProceduralCompactMesh::UnpackTangent(uint32 Packed, float& OutBinormalSign)
+{
+  OutBinormalSign = (Packed & 1u) != 0 ? -1.0f : 1.0f;
+  return UnpackNormal(Packed & ~1u);
+}
@@ -3,6 +3,8 @@
 #include "CarlaMeshGeneration.h"
 #include "Modules/ModuleManager.h"
 #include "Generation/PoissonDiscSampling.h"
+#include "Generation/PoissonDiscCache.h"
+#include "UObject/UObjectGlobals.h"
 
 
 #define LOCTEXT_NAMESPACE "FCarlaMeshGenerationModule"
@@ -12,12 +14,19 @@ DEFINE_LOG_CATEGORY(LogCarlaMeshGeneration);
 void FCarlaMeshGenerationModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	// Incremental sampling results of components destroyed by the collection are no longer reachable.
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([]()
+		{
+			FPoissonIncrementalStore::Get().RemoveStale();
+		});
 }
 
 void FCarlaMeshGenerationModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,149 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/AssetSaveQueue.h"
+
+#include "Editor.h"
+#include "Misc/PackageName.h"
+#include "Misc/ScopedSlowTask.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+DEFINE_LOG_CATEGORY(LogCarlaAssetSaveQueue);
+
+#define LOCTEXT_NAMESPACE "AssetSaveQueue"
+
+namespace
+{
+  FSavePackageResultStruct SavePackageToDisk(UPackage* Package, uint32 SaveFlags)
+  {
+    const FString PackageFileName = FPackageName::LongPackageNameToFilename(
+      Package->GetName(), FPackageName::GetAssetPackageExtension());
+    FSavePackageArgs SaveArgs;
+    SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+    SaveArgs.SaveFlags = SaveFlags;
+    const FSavePackageResultStruct Result =
+      UPackage::Save(Package, Package->FindAssetInPackage(), *PackageFileName, SaveArgs);
+    if (Result.Result != ESavePackageResult::Success)
+    {
+      UE_LOG(LogCarlaAssetSaveQueue, Error, TEXT("Failed to save package %s"), *Package->GetName());
+    }
+    return Result;
+  }
+}
+
+UAssetSaveQueueSubsystem* UAssetSaveQueueSubsystem::Get()
+{
+  return GEditor ? GEditor->GetEditorSubsystem<UAssetSaveQueueSubsystem>() : nullptr;
+}
+
+void UAssetSaveQueueSubsystem::EnqueueOrSave(UPackage* Package)
+{
+  if (UAssetSaveQueueSubsystem* SaveQueue = Get())
+  {
+    SaveQueue->Enqueue(Package);
+  }
+  else if (Package != nullptr)
+  {
+    SavePackageToDisk(Package, SAVE_None);
+  }
+}
+
+void UAssetSaveQueueSubsystem::Enqueue(UPackage* Package)
+{
+  if (Package == nullptr)
+  {
+    return;
+  }
+
+  bool bAlreadyQueued = false;
+  QueuedNames.Add(Package->GetFName(), &bAlreadyQueued);
+  if (bAlreadyQueued)
+  {
+    return;
+  }
+  Queue.Add({ Package->GetFName(), Package });
+
+  if (GetNumQueued() >= BatchSize)
+  {
+    SaveQueued(GetNumQueued(), TNumericLimits<double>::Max());
+  }
+}
+
+void UAssetSaveQueueSubsystem::Flush()
+{
+  FScopedSlowTask SlowTask(GetNumQueued(), LOCTEXT("Flush", "Saving generated assets"));
+  while (GetNumQueued() > 0)
+  {
+    SlowTask.EnterProgressFrame();
+    SaveQueued(1, TNumericLimits<double>::Max());
+  }
+  UPackage::WaitForAsyncFileWrites();
+  InFlightBytes = 0;
+}
+
+void UAssetSaveQueueSubsystem::Deinitialize()
+{
+  Flush();
+  Super::Deinitialize();
+}
+
+void UAssetSaveQueueSubsystem::Tick(float DeltaTime)
+{
+  SaveQueued(MAX_int32, FPlatformTime::Seconds() + TickBudgetSeconds);
+}
+
+TStatId UAssetSaveQueueSubsystem::GetStatId() const
+{
+  RETURN_QUICK_DECLARE_CYCLE_STAT(UAssetSaveQueueSubsystem, STATGROUP_Tickables);
+}
+
+void UAssetSaveQueueSubsystem::SaveQueued(int32 MaxPackages, double Deadline)
+{
+  int32 NumAttempted = 0;
+  while (GetNumQueued() > 0 && NumAttempted < MaxPackages && FPlatformTime::Seconds() < Deadline)
+  {
+    // Packages collected since they were queued are skipped.
+    const FQueuedPackage& Entry = Queue[QueueHead++];
+    QueuedNames.Remove(Entry.Name);
+    if (UPackage* Package = Entry.Package.Get())
+    {
+      NumSaved += SavePackage(Package) ? 1 : 0;
+    }
+    ++NumAttempted;
+  }
+
+  if (GetNumQueued() == 0)
+  {
+    Queue.Reset();
+    QueueHead = 0;
+  }
+
+  if (NumAttempted > 0)
+  {
+    OnProgress.Broadcast(NumSaved, NumSaved + GetNumQueued());
+  }
+}
+
+bool UAssetSaveQueueSubsystem::SavePackage(UPackage* Package)
+{
+  // The package is serialized here and its file written in the background.
+  const FSavePackageResultStruct Result = SavePackageToDisk(Package, SAVE_Async);
+  if (Result.Result != ESavePackageResult::Success)
+  {
+    return false;
+  }
+
+  InFlightBytes += Result.TotalFileSize;
+  if (InFlightBytes > (int64)MaxInFlightMB * 1024 * 1024)
+  {
+    UPackage::WaitForAsyncFileWrites();
+    InFlightBytes = 0;
+  }
+  return true;
+}
+
+#undef LOCTEXT_NAMESPACE
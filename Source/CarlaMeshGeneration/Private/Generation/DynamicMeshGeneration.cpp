@@ -22,11 +22,14 @@
 #include "UObject/Package.h"
 #include "Misc/PackageName.h"
 #include "UObject/SavePackage.h"
+#include "Hash/CityHash.h"
 
 // Carla C++ headers
 
 // Carla plugin headers
 #include "CarlaMeshGeneration.h"
+#include "Generation/AssetSaveQueue.h"
+#include "Generation/ProceduralMeshSourceHash.h"
 #include "Paths/GenerationPathsHelper.h"
 
 DEFINE_LOG_CATEGORY(LogCarlaDynamicMeshGeneration);
@@ -57,7 +60,39 @@ UStaticMesh* UDynamicMeshGeneration::CreateMeshFromPoints(
         return nullptr;
     }
 
-    // Step 1: Build a DynamicMesh
+    // Step 1: Construct full package name (path + mesh name)
+    FString CleanAssetPath = AssetPath;
+    MeshName = FName(*FString::Printf(TEXT("SM_%s"), *MeshName.ToString()));
+    FString PackageName = CleanAssetPath / MeshName.ToString();
+    FString UniquePackageName;
+    if (!FPackageName::TryConvertFilenameToLongPackageName(PackageName, UniquePackageName))
+    {
+      UE_LOG(LogCarlaDynamicMeshGeneration, Error, TEXT("Invalid package name: %s"), *PackageName);
+      return nullptr;
+    }
+
+    // Skip everything if the existing asset was generated from the same input
+    struct
+    {
+      uint64 Version;
+      FVector Offset;
+      uint8 bFlipped;
+    } Header;
+    FMemory::Memzero(Header);
+    Header.Version = UProceduralMeshSourceHash::GeneratorVersion;
+    Header.Offset = Offset;
+    Header.bFlipped = bFlipped;
+    const uint64 ContentHash = CityHash64WithSeed(
+      (const char*)Points3D.GetData(),
+      (uint32)(Points3D.Num() * sizeof(FVector)),
+      CityHash64((const char*)&Header, sizeof(Header)));
+    if (UStaticMesh* ExistingMesh = UProceduralMeshSourceHash::FindUnchangedMesh(UniquePackageName, MeshName, ContentHash))
+    {
+      UE_LOG(LogCarlaDynamicMeshGeneration, Log, TEXT("StaticMesh asset is up to date: %s"), *PackageName);
+      return ExistingMesh;
+    }
+
+    // Step 2: Build a DynamicMesh
     UDynamicMesh* DynamicMesh = NewObject<UDynamicMesh>();
     FGeometryScriptPrimitiveOptions Options;
     Options.bFlipOrientation = bFlipped;
@@ -75,7 +110,7 @@ UStaticMesh* UDynamicMeshGeneration::CreateMeshFromPoints(
     );
 
 
-    // Step 2: Apply height (Z) from original Points3D + Offset
+    // Step 3: Apply height (Z) from original Points3D + Offset
     DynamicMesh->EditMesh([&](FDynamicMesh3& Mesh)
       {
         for (int32 vid : Mesh.VertexIndicesItr())
@@ -96,17 +131,7 @@ UStaticMesh* UDynamicMeshGeneration::CreateMeshFromPoints(
       });
 
 
-    // Step 2: Construct full package name (path + mesh name)
-    FString CleanAssetPath = AssetPath;
-    MeshName = FName(*FString::Printf(TEXT("SM_%s"), *MeshName.ToString()));
-    FString PackageName = CleanAssetPath / MeshName.ToString();
-    FString UniquePackageName;
-    if (!FPackageName::TryConvertFilenameToLongPackageName(PackageName, UniquePackageName))
-    {
-      UE_LOG(LogCarlaDynamicMeshGeneration, Error, TEXT("Invalid package name: %s"), *PackageName);
-      return nullptr;
-    }
-    // Step 3: Create the package
+    // Step 4: Create the package
     UPackage* Package = CreatePackage(*UniquePackageName);
     if (!Package)
     {
@@ -126,7 +151,7 @@ UStaticMesh* UDynamicMeshGeneration::CreateMeshFromPoints(
       return nullptr;
     }
 
-    // Step 4: Copy mesh data into the StaticMesh using Geometry Script
+    // Step 5: Copy mesh data into the StaticMesh using Geometry Script
     FGeometryScriptCopyMeshToAssetOptions CopyOptions;
     //CopyOptions.bRecomputeNormals = true;
     //CopyOptions.bRecomputeTangents = true;
@@ -156,15 +181,13 @@ UStaticMesh* UDynamicMeshGeneration::CreateMeshFromPoints(
         return nullptr;
     }
 
-    // Step 5: Register and save asset
+    UProceduralMeshSourceHash::SetHash(NewStaticMesh, ContentHash);
+
+    // Step 6: Register and save asset. The file is written in the background,
+    // call UAssetSaveQueueSubsystem::Flush to wait for it.
     FAssetRegistryModule::AssetCreated(NewStaticMesh);
     Package->MarkPackageDirty();
-
-    FString PackageFileName = FPackageName::LongPackageNameToFilename(UniquePackageName, FPackageName::GetAssetPackageExtension());
-    FSavePackageArgs SaveArgs;
-    SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
-    SaveArgs.SaveFlags = SAVE_None;
-    UPackage::SavePackage(Package, NewStaticMesh, *PackageFileName, SaveArgs);
+    UAssetSaveQueueSubsystem::EnqueueOrSave(Package);
 
     UE_LOG(LogCarlaDynamicMeshGeneration, Log, TEXT("Created StaticMesh asset: %s"), *PackageName);
 
@@ -8,17 +8,34 @@
 
 // Engine headers
 #include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
 #include "Materials/MaterialInstance.h"
+#include "MaterialShared.h"
 #include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
 #include "RenderingThread.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include "Components/SceneComponent.h"
 #include "PhysicsEngine/BodySetup.h"
+#include "Algo/Accumulate.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+#include "Misc/PackageName.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 // Carla C++ headers
 
 // Carla plugin headers
 #include "CarlaMeshGeneration.h"
+#include "Generation/AssetSaveQueue.h"
+#include "Generation/ProceduralMeshChunking.h"
+#include "Generation/ProceduralMeshCollision.h"
+#include "Generation/ProceduralMeshFile.h"
+#include "Generation/ProceduralMeshSourceHash.h"
 #include "Paths/GenerationPathsHelper.h"
+#include "Generation/SpatialIndex2D.h"
 
 #if WITH_EDITOR
 #include "Editor/Transactor.h"
@@ -27,127 +44,1308 @@
 #if ENGINE_MAJOR_VERSION < 5
 using V2 = FVector2D;
 using V3 = FVector;
+using V4 = FVector4;
 #else
 using V2 = FVector2f;
 using V3 = FVector3f;
+using V4 = FVector4f;
 #endif
 
 DEFINE_LOG_CATEGORY(LogCarlaMapGenFunctionLibrary);
 static const float OSMToCentimetersScaleFactor = 100.0f;
 
+namespace
+{
+  /** Reads a FProceduralCustomMesh and its separate tangents for AppendMeshData. */
+  struct FCustomMeshReader
+  {
+    const FProceduralCustomMesh& Data;
+    const TArray<FProcMeshTangent>& Tangents;
+
+    int32 NumVertices() const { return Data.Vertices.Num(); }
+    TConstArrayView<int32> GetTriangles() const { return Data.Triangles; }
+    TConstArrayView<FVector> GetPositions() const { return Data.Vertices; }
+    bool HasNormals() const { return Data.Normals.Num() == NumVertices(); }
+    bool HasTangents() const { return Tangents.Num() == NumVertices(); }
+    bool HasUV0() const { return Data.UV0.Num() == NumVertices(); }
+    bool HasColors() const { return Data.VertexColor.Num() == NumVertices(); }
+
+    V3 GetNormal(int32 VertexIndex) const { return V3(Data.Normals[VertexIndex]); }
+    V2 GetUV0(int32 VertexIndex) const { return V2(Data.UV0[VertexIndex]); }
+    V4 GetColor(int32 VertexIndex) const { return V4(Data.VertexColor[VertexIndex]); }
+
+    V3 GetTangent(int32 VertexIndex, float& OutBinormalSign) const
+    {
+      OutBinormalSign = Tangents[VertexIndex].bFlipTangentY ? -1.f : 1.f;
+      return V3(Tangents[VertexIndex].TangentX);
+    }
+  };
+
+  /** Reads a FProceduralCompactMesh, or a view of one, for AppendMeshData. */
+  struct FCompactMeshReader
+  {
+    FProceduralCompactMeshView Data;
+
+    int32 NumVertices() const { return Data.NumVertices(); }
+    TConstArrayView<int32> GetTriangles() const { return Data.Triangles; }
+    TConstArrayView<FVector3f> GetPositions() const { return Data.Positions; }
+    bool HasNormals() const { return Data.HasNormals(); }
+    bool HasTangents() const { return Data.HasTangents(); }
+    bool HasUV0() const { return Data.HasUV0(); }
+    bool HasColors() const { return Data.HasColors(); }
+
+    V3 GetNormal(int32 VertexIndex) const { return V3(FProceduralCompactMesh::UnpackNormal(Data.Normals[VertexIndex])); }
+    V2 GetUV0(int32 VertexIndex) const { return V2(FVector2f(Data.UV0[VertexIndex])); }
+    V4 GetColor(int32 VertexIndex) const { return V4(FLinearColor(Data.Colors[VertexIndex])); }
+
+    V3 GetTangent(int32 VertexIndex, float& OutBinormalSign) const
+    {
+      return V3(FProceduralCompactMesh::UnpackTangent(Data.Tangents[VertexIndex], OutBinormalSign));
+    }
+  };
+
+  /** Calls Func with a reader for whichever mesh the section holds. */
+  template <typename TFunc>
+  decltype(auto) ReadSection(const FProceduralMeshSection& Section, TFunc&& Func)
+  {
+    if (Section.CompactMesh.NumVertices() > 0)
+    {
+      return Func(FCompactMeshReader{ Section.CompactMesh.GetView() });
+    }
+    return Func(FCustomMeshReader{ Section.Mesh, Section.Tangents });
+  }
+
+  /**
+   * How the elements of a mesh description map to the input data. Vertex and
+   * instance IDs are handed out contiguously, so entry I describes ID I.
+   */
+  struct FMeshElementMapping
+  {
+    /** Input vertex each vertex takes its position from. */
+    TArray<int32> VertexSources;
+
+    /** Vertex of each instance. */
+    TArray<int32> InstanceVertices;
+
+    /** Input vertex each instance takes its attributes from. */
+    TArray<int32> InstanceSources;
+
+    /** Instance of each triangle corner, three per triangle. */
+    TArray<int32> CornerInstances;
+  };
+
+  /** Attributes of a vertex instance, compared bitwise. */
+  struct FInstanceKey
+  {
+    int32 Vertex = 0;
+    V3 Normal = V3(0, 0, 0);
+    V3 Tangent = V3(0, 0, 0);
+    float BinormalSign = 0.0f;
+    V2 UV = V2(0, 0);
+
+    bool operator==(const FInstanceKey& Other) const
+    {
+      return FMemory::Memcmp(this, &Other, sizeof(FInstanceKey)) == 0;
+    }
+
+    friend uint32 GetTypeHash(const FInstanceKey& Key)
+    {
+      return FCrc::MemCrc32(&Key, sizeof(FInstanceKey));
+    }
+  };
+
+  /**
+   * For each vertex, the first vertex within Tolerance of it, which is itself
+   * when there is none. Vertices are bucketed in a hashed grid of
+   * Tolerance-sized cells so only neighbouring cells are searched.
+   */
+  template <typename TPosition>
+  TArray<int32> FindCoincidentVertices(TConstArrayView<TPosition> Vertices, float Tolerance)
+  {
+    const double CellSize = Tolerance > 0.0f ? Tolerance : 1.0;
+    const double ToleranceSquared = FMath::Square((double)Tolerance);
+    const int64 Reach = Tolerance > 0.0f ? 1 : 0;
+
+    auto GetCellHash = [](int64 X, int64 Y, int64 Z)
+    {
+      return (uint64)X * 0x9E3779B97F4A7C15ull ^
+        (uint64)Y * 0xC2B2AE3D27D4EB4Full ^
+        (uint64)Z * 0x165667B19E3779F9ull;
+    };
+
+    // Only vertices that are kept are linked into the cells.
+    TMap<uint64, int32> CellHeads;
+    CellHeads.Reserve(Vertices.Num());
+    TArray<int32> NextInCell;
+    NextInCell.Init(INDEX_NONE, Vertices.Num());
+
+    TArray<int32> Result;
+    Result.SetNumUninitialized(Vertices.Num());
+    for (int32 VertexIndex = 0; VertexIndex < Vertices.Num(); ++VertexIndex)
+    {
+      const FVector Position(Vertices[VertexIndex]);
+      const int64 CellX = (int64)FMath::FloorToDouble(Position.X / CellSize);
+      const int64 CellY = (int64)FMath::FloorToDouble(Position.Y / CellSize);
+      const int64 CellZ = (int64)FMath::FloorToDouble(Position.Z / CellSize);
+
+      int32 Match = INDEX_NONE;
+      for (int64 X = CellX - Reach; X <= CellX + Reach && Match == INDEX_NONE; ++X)
+      {
+        for (int64 Y = CellY - Reach; Y <= CellY + Reach && Match == INDEX_NONE; ++Y)
+        {
+          for (int64 Z = CellZ - Reach; Z <= CellZ + Reach && Match == INDEX_NONE; ++Z)
+          {
+            const int32* Head = CellHeads.Find(GetCellHash(X, Y, Z));
+            for (int32 Other = Head ? *Head : INDEX_NONE; Other != INDEX_NONE; Other = NextInCell[Other])
+            {
+              if (FVector::DistSquared(Position, FVector(Vertices[Other])) <= ToleranceSquared)
+              {
+                Match = Other;
+                break;
+              }
+            }
+          }
+        }
+      }
+
+      if (Match == INDEX_NONE)
+      {
+        int32& Head = CellHeads.FindOrAdd(GetCellHash(CellX, CellY, CellZ), INDEX_NONE);
+        NextInCell[VertexIndex] = Head;
+        Head = VertexIndex;
+        Match = VertexIndex;
+      }
+      Result[VertexIndex] = Match;
+    }
+    return Result;
+  }
+
+  template <typename TMeshReader>
+  FMeshElementMapping MapElements(
+    const TMeshReader& Reader,
+    const FProceduralMeshBuildSettings& BuildSettings)
+  {
+    const TConstArrayView<int32> Triangles = Reader.GetTriangles();
+    const int32 NumVertex = Reader.NumVertices();
+    const int32 NumCorners = Triangles.Num() / 3 * 3;
+
+    FMeshElementMapping Mapping;
+    if (!BuildSettings.bWeldVertices)
+    {
+      // One vertex per input vertex and one instance per triangle corner.
+      Mapping.VertexSources.SetNumUninitialized(NumVertex);
+      for (int32 VertexIndex = 0; VertexIndex < NumVertex; ++VertexIndex)
+      {
+        Mapping.VertexSources[VertexIndex] = VertexIndex;
+      }
+      Mapping.InstanceVertices.Append(Triangles.GetData(), NumCorners);
+      Mapping.InstanceSources.Append(Triangles.GetData(), NumCorners);
+      Mapping.CornerInstances.SetNumUninitialized(NumCorners);
+      for (int32 IndiceIndex = 0; IndiceIndex < NumCorners; ++IndiceIndex)
+      {
+        Mapping.CornerInstances[IndiceIndex] = IndiceIndex;
+      }
+      return Mapping;
+    }
+
+    const TArray<int32> Coincident = FindCoincidentVertices(Reader.GetPositions(), BuildSettings.WeldTolerance);
+    TArray<int32> InputToVertex;
+    InputToVertex.SetNumUninitialized(NumVertex);
+    for (int32 VertexIndex = 0; VertexIndex < NumVertex; ++VertexIndex)
+    {
+      // A coincident vertex always comes before the vertices merged into it.
+      InputToVertex[VertexIndex] = Coincident[VertexIndex] == VertexIndex ?
+        Mapping.VertexSources.Add(VertexIndex) :
+        InputToVertex[Coincident[VertexIndex]];
+    }
+
+    // Every corner using an input vertex has the same attributes, so the
+    // instance only has to be looked up once per input vertex.
+    const bool bHasTangents = Reader.HasTangents();
+    const bool bHasUV0 = Reader.HasUV0();
+    TArray<int32> InputToInstance;
+    InputToInstance.Init(INDEX_NONE, NumVertex);
+    TMap<FInstanceKey, int32> Instances;
+    Instances.Reserve(Mapping.VertexSources.Num());
+    auto GetInstance = [&](int32 VertexIndex)
+    {
+      int32& Instance = InputToInstance[VertexIndex];
+      if (Instance == INDEX_NONE)
+      {
+        FInstanceKey Key;
+        Key.Vertex = InputToVertex[VertexIndex];
+        Key.Normal = Reader.GetNormal(VertexIndex);
+        if (bHasTangents)
+        {
+          Key.Tangent = Reader.GetTangent(VertexIndex, Key.BinormalSign);
+        }
+        if (bHasUV0)
+        {
+          Key.UV = Reader.GetUV0(VertexIndex);
+        }
+        Instance = Instances.FindOrAdd(Key, Mapping.InstanceVertices.Num());
+        if (Instance == Mapping.InstanceVertices.Num())
+        {
+          Mapping.InstanceVertices.Add(Key.Vertex);
+          Mapping.InstanceSources.Add(VertexIndex);
+        }
+      }
+      return Instance;
+    };
+
+    Mapping.CornerInstances.Reserve(NumCorners);
+    for (int32 IndiceIndex = 0; IndiceIndex < NumCorners; IndiceIndex += 3)
+    {
+      const int32* Corners = &Triangles[IndiceIndex];
+      const int32 A = InputToVertex[Corners[0]];
+      const int32 B = InputToVertex[Corners[1]];
+      const int32 C = InputToVertex[Corners[2]];
+      if (A == B || B == C || C == A)
+      {
+        continue;
+      }
+      Mapping.CornerInstances.Add(GetInstance(Corners[0]));
+      Mapping.CornerInstances.Add(GetInstance(Corners[1]));
+      Mapping.CornerInstances.Add(GetInstance(Corners[2]));
+    }
+
+    UE_LOG(LogCarlaMapGenFunctionLibrary, Verbose,
+      TEXT("Welding kept %d of %d vertices, %d instances for %d corners and %d of %d triangles"),
+      Mapping.VertexSources.Num(), NumVertex,
+      Mapping.InstanceVertices.Num(), NumCorners,
+      Mapping.CornerInstances.Num() / 3, NumCorners / 3);
+    return Mapping;
+  }
+
+  /** Whether every triangle corner refers to an existing vertex. */
+  template <typename TMeshReader>
+  bool ValidateTriangles(const TMeshReader& Reader)
+  {
+    const TConstArrayView<int32> Triangles = Reader.GetTriangles();
+    for (int32 IndiceIndex = 0; IndiceIndex < Triangles.Num() / 3 * 3; ++IndiceIndex)
+    {
+      if ((uint32)Triangles[IndiceIndex] >= (uint32)Reader.NumVertices())
+      {
+        UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Triangle index %d refers to missing vertex %d"),
+          IndiceIndex, Triangles[IndiceIndex]);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  FMeshDescription CreateEmptyMeshDescription()
+  {
+    FMeshDescription MeshDescription;
+    FStaticMeshAttributes AttributeGetter(MeshDescription);
+    AttributeGetter.Register();
+    // Only UV 0 is generated. The build adds the lightmap channel.
+    AttributeGetter.GetVertexInstanceUVs().SetNumIndices(1);
+    return MeshDescription;
+  }
+
+  /** Adds a polygon group whose material slot is named after Material. */
+  FPolygonGroupID CreateMaterialPolygonGroup(FMeshDescription& MeshDescription, UMaterialInterface* Material)
+  {
+    FStaticMeshAttributes AttributeGetter(MeshDescription);
+    auto PolygonGroupNames = AttributeGetter.GetPolygonGroupMaterialSlotNames();
+    FPolygonGroupID NewPolygonGroup = MeshDescription.CreatePolygonGroup();
+
+    if( Material != nullptr ){
+      // Materials from different folders may share a name, but slots may not.
+      FName SlotName = Material->GetFName();
+      for (int32 Suffix = 1; ; ++Suffix)
+      {
+        bool bTaken = false;
+        for (const FPolygonGroupID PolygonGroup : MeshDescription.PolygonGroups().GetElementIDs())
+        {
+          bTaken |= PolygonGroup != NewPolygonGroup && PolygonGroupNames[PolygonGroup] == SlotName;
+        }
+        if (!bTaken)
+        {
+          break;
+        }
+        SlotName = FName(Material->GetFName(), Suffix);
+      }
+      PolygonGroupNames[NewPolygonGroup] = SlotName;
+    }else{
+      UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("MaterialInstance is nullptr"));
+    }
+    return NewPolygonGroup;
+  }
+
+  /**
+   * Appends Data to MeshDescription as triangles of PolygonGroup. Relies on
+   * the mesh description never having had elements removed, so new IDs
+   * follow on from the existing ones.
+   */
+  template <typename TMeshReader>
+  void AppendMeshData(
+    FMeshDescription& MeshDescription,
+    const TMeshReader& Reader,
+    FPolygonGroupID PolygonGroup,
+    const FProceduralMeshBuildSettings& BuildSettings)
+  {
+    const FMeshElementMapping Mapping = MapElements(Reader, BuildSettings);
+    const int32 NumMeshVertices = Mapping.VertexSources.Num();
+    const int32 NumInstances = Mapping.InstanceVertices.Num();
+    const int32 NumTri = Mapping.CornerInstances.Num() / 3;
+
+    FStaticMeshAttributes AttributeGetter(MeshDescription);
+    auto VertexPositions = AttributeGetter.GetVertexPositions();
+    auto Tangents = AttributeGetter.GetVertexInstanceTangents();
+    auto BinormalSigns = AttributeGetter.GetVertexInstanceBinormalSigns();
+    auto Normals = AttributeGetter.GetVertexInstanceNormals();
+    auto Colors = AttributeGetter.GetVertexInstanceColors();
+    auto UVs = AttributeGetter.GetVertexInstanceUVs();
+
+    // Calculate the totals for each ProcMesh element type
+    MeshDescription.ReserveNewVertices(NumMeshVertices);
+    MeshDescription.ReserveNewVertexInstances(NumInstances);
+    MeshDescription.ReserveNewTriangles(NumTri);
+    MeshDescription.ReserveNewPolygons(NumTri);
+    MeshDescription.ReserveNewEdges(NumTri * 2);
+
+    // IDs are handed out in creation order without gaps, so the mapping
+    // entries line up with the IDs past the base and the attributes can be
+    // written straight into their raw arrays by index.
+    const int32 VertexBase = MeshDescription.Vertices().Num();
+    const int32 InstanceBase = MeshDescription.VertexInstances().Num();
+    for (int32 VertexIndex = 0; VertexIndex < NumMeshVertices; ++VertexIndex)
+    {
+      const FVertexID VertexID = MeshDescription.CreateVertex();
+      check(VertexID.GetValue() == VertexBase + VertexIndex);
+    }
+    for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+    {
+      const FVertexInstanceID VertexInstanceID = MeshDescription.CreateVertexInstance(
+        FVertexID(VertexBase + Mapping.InstanceVertices[InstanceIndex]));
+      check(VertexInstanceID.GetValue() == InstanceBase + InstanceIndex);
+    }
+
+    const TArrayView<V3> RawPositions = VertexPositions.GetRawArray();
+    const auto Positions = Reader.GetPositions();
+    using FPosition = std::remove_const_t<typename decltype(Positions)::ElementType>;
+    bool bPositionsCopied = false;
+    if constexpr (std::is_same_v<FPosition, V3>)
+    {
+      if (NumMeshVertices == Positions.Num())
+      {
+        // Every input vertex is kept and in order, so positions already in
+        // the description's format go over in one copy.
+        FMemory::Memcpy(RawPositions.GetData() + VertexBase, Positions.GetData(), NumMeshVertices * sizeof(V3));
+        bPositionsCopied = true;
+      }
+    }
+    if (!bPositionsCopied)
+    {
+      ParallelFor(NumMeshVertices, [&](int32 VertexIndex)
+        {
+          RawPositions[VertexBase + VertexIndex] = V3(Positions[Mapping.VertexSources[VertexIndex]]);
+        });
+    }
+
+    const bool bHasTangents = Reader.HasTangents();
+    const bool bHasUV0 = Reader.HasUV0();
+    const bool bHasColors = Reader.HasColors();
+    const TArrayView<V3> RawNormals = Normals.GetRawArray();
+    const TArrayView<V3> RawTangents = Tangents.GetRawArray();
+    const TArrayView<float> RawBinormalSigns = BinormalSigns.GetRawArray();
+    const TArrayView<V4> RawColors = Colors.GetRawArray();
+    const TArrayView<V2> RawUV0 = UVs.GetRawArray(0);
+
+    ParallelFor(NumInstances, [&](int32 InstanceIndex)
+      {
+        const int32 VertexIndex = Mapping.InstanceSources[InstanceIndex];
+        const int32 Target = InstanceBase + InstanceIndex;
+        RawNormals[Target] = Reader.GetNormal(VertexIndex);
+        if (bHasTangents)
+        {
+          RawTangents[Target] = Reader.GetTangent(VertexIndex, RawBinormalSigns[Target]);
+        }
+        RawColors[Target] = bHasColors ? Reader.GetColor(VertexIndex) : V4(FLinearColor(0,0,0));
+        RawUV0[Target] = bHasUV0 ? Reader.GetUV0(VertexIndex) : V2(0,0);
+      });
+
+    for (int32 TriIdx = 0; TriIdx < NumTri; TriIdx++)
+    {
+      const FVertexInstanceID VertexInstanceIDs[3] = {
+        FVertexInstanceID(InstanceBase + Mapping.CornerInstances[TriIdx * 3]),
+        FVertexInstanceID(InstanceBase + Mapping.CornerInstances[TriIdx * 3 + 1]),
+        FVertexInstanceID(InstanceBase + Mapping.CornerInstances[TriIdx * 3 + 2])
+      };
+
+      // Insert a triangle into the mesh
+      MeshDescription.CreateTriangle(PolygonGroup, VertexInstanceIDs);
+    }
+  }
+
+  /**
+   * Normals for a mesh that comes without them, averaged over the corners at
+   * each position weighted by corner angle and triangle area. Vertices at the
+   * same position share the normal, so UV seams do not show as hard edges.
+   */
+  template <typename TMeshReader>
+  TArray<V3> ComputeVertexNormals(const TMeshReader& Reader)
+  {
+    TRACE_CPUPROFILER_EVENT_SCOPE(ComputeVertexNormals);
+
+    const auto Positions = Reader.GetPositions();
+    const TConstArrayView<int32> Triangles = Reader.GetTriangles();
+    const int32 NumVertex = Reader.NumVertices();
+    const int32 NumTri = Triangles.Num() / 3;
+    const TArray<int32> Coincident = FindCoincidentVertices(Positions, 0.0f);
+
+    // Each corner's share, computed in parallel over the triangles.
+    TArray<FVector> CornerNormals;
+    CornerNormals.SetNumUninitialized(NumTri * 3);
+    ParallelFor(NumTri, [&](int32 TriIdx)
+      {
+        const FVector Corners[3] = {
+          FVector(Positions[Triangles[TriIdx * 3]]),
+          FVector(Positions[Triangles[TriIdx * 3 + 1]]),
+          FVector(Positions[Triangles[TriIdx * 3 + 2]])
+        };
+        // Same winding as FStaticMeshOperations::ComputeTriangleTangentsAndNormals.
+        const FVector AreaNormal = (Corners[2] - Corners[0]) ^ (Corners[1] - Corners[0]);
+        for (int32 Corner = 0; Corner < 3; ++Corner)
+        {
+          const FVector ToNext = (Corners[(Corner + 1) % 3] - Corners[Corner]).GetSafeNormal();
+          const FVector ToPrev = (Corners[(Corner + 2) % 3] - Corners[Corner]).GetSafeNormal();
+          const double Angle = FMath::Acos(FMath::Clamp(ToNext | ToPrev, -1.0, 1.0));
+          CornerNormals[TriIdx * 3 + Corner] = AreaNormal * Angle;
+        }
+      });
+
+    // Corners grouped by position in compressed rows, so every position sums
+    // its own corners and the sums run in parallel without atomics.
+    TArray<int32> RowStarts;
+    RowStarts.SetNumZeroed(NumVertex + 1);
+    for (int32 Corner = 0; Corner < NumTri * 3; ++Corner)
+    {
+      ++RowStarts[Coincident[Triangles[Corner]] + 1];
+    }
+    for (int32 VertexIndex = 0; VertexIndex < NumVertex; ++VertexIndex)
+    {
+      RowStarts[VertexIndex + 1] += RowStarts[VertexIndex];
+    }
+    TArray<int32> RowCorners;
+    RowCorners.SetNumUninitialized(NumTri * 3);
+    TArray<int32> RowFill(RowStarts.GetData(), NumVertex);
+    for (int32 Corner = 0; Corner < NumTri * 3; ++Corner)
+    {
+      RowCorners[RowFill[Coincident[Triangles[Corner]]]++] = Corner;
+    }
+
+    TArray<V3> Normals;
+    Normals.SetNumUninitialized(NumVertex);
+    ParallelFor(NumVertex, [&](int32 VertexIndex)
+      {
+        if (Coincident[VertexIndex] != VertexIndex)
+        {
+          return;
+        }
+        FVector Sum = FVector::ZeroVector;
+        for (int32 Row = RowStarts[VertexIndex]; Row < RowStarts[VertexIndex + 1]; ++Row)
+        {
+          Sum += CornerNormals[RowCorners[Row]];
+        }
+        Normals[VertexIndex] = V3(Sum.GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector));
+      });
+
+    // A coincident vertex always comes before the vertices merged into it.
+    for (int32 VertexIndex = 0; VertexIndex < NumVertex; ++VertexIndex)
+    {
+      Normals[VertexIndex] = Normals[Coincident[VertexIndex]];
+    }
+    return Normals;
+  }
+
+  /** A reader with normals computed by ComputeVertexNormals. */
+  template <typename TMeshReader>
+  struct TComputedNormalsReader : TMeshReader
+  {
+    TArray<V3> ComputedNormals;
+
+    bool HasNormals() const { return true; }
+    V3 GetNormal(int32 VertexIndex) const { return ComputedNormals[VertexIndex]; }
+  };
+
+  /** AppendMeshData, computing the normals first if Reader has none. */
+  template <typename TMeshReader>
+  void AppendMeshSection(
+    FMeshDescription& MeshDescription,
+    const TMeshReader& Reader,
+    FPolygonGroupID PolygonGroup,
+    const FProceduralMeshBuildSettings& BuildSettings)
+  {
+    if (Reader.HasNormals())
+    {
+      AppendMeshData(MeshDescription, Reader, PolygonGroup, BuildSettings);
+      return;
+    }
+    const TComputedNormalsReader<TMeshReader> WithNormals{ { Reader }, ComputeVertexNormals(Reader) };
+    AppendMeshData(MeshDescription, WithNormals, PolygonGroup, BuildSettings);
+  }
+
+  /**
+   * Fills in the tangents of a description built from input without them.
+   * This is the same MikkTSpace the static mesh build would run, but it runs
+   * here, on the worker building the description.
+   */
+  void ComputeMissingTangents(FMeshDescription& MeshDescription)
+  {
+    TRACE_CPUPROFILER_EVENT_SCOPE(ComputeMissingTangents);
+    FStaticMeshOperations::ComputeMikktTangents(MeshDescription, true);
+  }
+
+  /** A mesh description waiting to become a static mesh asset. */
+  struct FPendingStaticMesh
+  {
+    FString PackageName;
+    FName MeshName;
+    FMeshDescription Description;
+
+    /** Material of each polygon group. */
+    TArray<UMaterialInterface*> Materials;
+
+    /** Whether the description has tangents, so the build need not compute them. */
+    bool bHasTangents = false;
+
+    /** Fraction of the triangles that the build keeps in LOD 0. */
+    float PercentTriangles = 1.0f;
+
+    /** Hash of the inputs, see UProceduralMeshSourceHash. */
+    uint64 ContentHash = 0;
+
+    /** Collision built by FProceduralMeshCollision. */
+    FKAggregateGeom SimpleCollision;
+    FMeshDescription CollisionDescription;
+  };
+
+  bool HaveTangents(const TArray<FProceduralMeshSection>& Sections)
+  {
+    return !Sections.ContainsByPredicate([](const FProceduralMeshSection& Section)
+      {
+        return !ReadSection(Section, [](const auto& Reader) { return Reader.HasTangents(); });
+      });
+  }
+
+  uint64 HashBytes(const void* Data, int64 Size, uint64 Hash)
+  {
+    return CityHash64WithSeed((const char*)Data, (uint32)Size, Hash);
+  }
+
+  template <typename T>
+  uint64 HashArray(TConstArrayView<T> Array, uint64 Hash)
+  {
+    const int32 Num = Array.Num();
+    Hash = HashBytes(&Num, sizeof(Num), Hash);
+    return HashBytes(Array.GetData(), (int64)Num * sizeof(T), Hash);
+  }
+
+  template <typename T>
+  uint64 HashArray(const TArray<T>& Array, uint64 Hash)
+  {
+    return HashArray(MakeArrayView(Array), Hash);
+  }
+
+  /** Hash of the settings that change the built mesh. */
+  uint64 HashBuildSettings(const FProceduralMeshBuildSettings& BuildSettings)
+  {
+    struct
+    {
+      uint64 Version;
+      uint8 bWeldVertices;
+      float WeldTolerance;
+      uint8 Collision;
+      int32 MaxConvexHulls;
+      float CollisionCellSize;
+      int32 CollisionTriangleBudget;
+      uint8 Nanite;
+      int32 NaniteMinTriangles;
+      float LODTriangleRatio;
+    } Header;
+    FMemory::Memzero(Header);
+    Header.Version = UProceduralMeshSourceHash::GeneratorVersion;
+    Header.bWeldVertices = BuildSettings.bWeldVertices;
+    Header.WeldTolerance = BuildSettings.bWeldVertices ? BuildSettings.WeldTolerance : 0.0f;
+    Header.Collision = (uint8)BuildSettings.Collision;
+    Header.MaxConvexHulls = BuildSettings.MaxConvexHulls;
+    Header.CollisionCellSize = BuildSettings.CollisionCellSize;
+    Header.CollisionTriangleBudget = BuildSettings.CollisionTriangleBudget;
+    Header.Nanite = (uint8)BuildSettings.Nanite;
+    Header.NaniteMinTriangles = BuildSettings.NaniteMinTriangles;
+    Header.LODTriangleRatio = BuildSettings.LODTriangleRatio;
+    return HashArray(BuildSettings.LODScreenSizes, CityHash64((const char*)&Header, sizeof(Header)));
+  }
+
+  uint64 HashSection(
+    const FProceduralCustomMesh& Data,
+    const TArray<FProcMeshTangent>& ParamTangents,
+    const UMaterialInterface* Material,
+    uint64 Hash)
+  {
+    Hash = HashArray(Data.Vertices, Hash);
+    Hash = HashArray(Data.Triangles, Hash);
+    Hash = HashArray(Data.Normals, Hash);
+    Hash = HashArray(Data.UV0, Hash);
+    Hash = HashArray(Data.VertexColor, Hash);
+
+    // FProcMeshTangent has padding after its flag, so it is hashed field by field.
+    TArray<FVector4> Tangents;
+    Tangents.Reserve(ParamTangents.Num());
+    for (const FProcMeshTangent& Tangent : ParamTangents)
+    {
+      Tangents.Emplace(Tangent.TangentX, Tangent.bFlipTangentY ? -1.0 : 1.0);
+    }
+    Hash = HashArray(Tangents, Hash);
+
+    const FString MaterialPath = Material != nullptr ? Material->GetPathName() : FString();
+    return HashBytes(*MaterialPath, MaterialPath.Len() * sizeof(TCHAR), Hash);
+  }
+
+  uint64 HashCompactSection(
+    const FProceduralCompactMeshView& Data,
+    const UMaterialInterface* Material,
+    uint64 Hash)
+  {
+    Hash = HashArray(Data.Positions, Hash);
+    Hash = HashArray(Data.Triangles, Hash);
+    Hash = HashArray(Data.Normals, Hash);
+    Hash = HashArray(Data.Tangents, Hash);
+    Hash = HashArray(Data.UV0, Hash);
+    Hash = HashArray(Data.Colors, Hash);
+
+    const FString MaterialPath = Material != nullptr ? Material->GetPathName() : FString();
+    return HashBytes(*MaterialPath, MaterialPath.Len() * sizeof(TCHAR), Hash);
+  }
+
+  uint64 HashSections(
+    const TArray<FProceduralMeshSection>& Sections,
+    const FProceduralMeshBuildSettings& BuildSettings)
+  {
+    uint64 Hash = HashBuildSettings(BuildSettings);
+    for (const FProceduralMeshSection& Section : Sections)
+    {
+      Hash = Section.CompactMesh.NumVertices() > 0 ?
+        HashCompactSection(Section.CompactMesh.GetView(), Section.Material, Hash) :
+        HashSection(Section.Mesh, Section.Tangents, Section.Material, Hash);
+    }
+    return Hash;
+  }
+
+  bool ShouldEnableNanite(
+    const FProceduralMeshBuildSettings& BuildSettings,
+    int32 NumTriangles,
+    TConstArrayView<UMaterialInterface*> Materials)
+  {
+    switch (BuildSettings.Nanite)
+    {
+    case EProceduralMeshNanite::Enabled:
+      return true;
+    case EProceduralMeshNanite::Disabled:
+      return false;
+    default:
+      break;
+    }
+
+    // Nanite does not render translucent materials, and small meshes draw
+    // faster through the regular pipeline.
+    const bool bTranslucent = Materials.ContainsByPredicate([](const UMaterialInterface* Material)
+      {
+        return Material != nullptr && IsTranslucentBlendMode(Material->GetBlendMode());
+      });
+    return !bTranslucent && NumTriangles >= BuildSettings.NaniteMinTriangles;
+  }
+
+  /**
+   * Creates a static mesh asset for each pending mesh whose entry in
+   * InOutMeshes is still null and builds them all with a single batch build,
+   * which runs the builds in parallel on the engine's build workers. Meshes
+   * without polygons stay null.
+   */
+  void CreateStaticMeshAssets(
+    TArrayView<FPendingStaticMesh> PendingMeshes,
+    const FProceduralMeshBuildSettings& BuildSettings,
+    TArray<UStaticMesh*>& InOutMeshes)
+  {
+    TRACE_CPUPROFILER_EVENT_SCOPE(CreateStaticMeshAssets);
+    check(IsInGameThread());
+
+    TArray<UStaticMesh*> CreatedMeshes;
+    CreatedMeshes.Reserve(PendingMeshes.Num());
+    TArray<UStaticMesh*> ComplexCollisionMeshes;
+    ComplexCollisionMeshes.Reserve(PendingMeshes.Num());
+    TArray<UStaticMesh*> MeshesToBuild;
+    MeshesToBuild.Reserve(PendingMeshes.Num());
+
+    for (int32 Index = 0; Index < PendingMeshes.Num(); ++Index)
+    {
+      FPendingStaticMesh& Pending = PendingMeshes[Index];
+      if (InOutMeshes[Index] != nullptr || Pending.Description.Polygons().Num() == 0)
+      {
+        continue;
+      }
+
+      FStaticMeshAttributes AttributeGetter(Pending.Description);
+      auto PolygonGroupNames = AttributeGetter.GetPolygonGroupMaterialSlotNames();
+
+      UPackage* Package = CreatePackage(*Pending.PackageName);
+      check(Package);
+      UStaticMesh* Mesh = NewObject<UStaticMesh>( Package, Pending.MeshName, RF_Public | RF_Standalone);
+
+      Mesh->SetLightingGuid(FGuid::NewGuid());
+      for (const FPolygonGroupID PolygonGroup : Pending.Description.PolygonGroups().GetElementIDs())
+      {
+        const FName SlotName = PolygonGroupNames[PolygonGroup];
+        Mesh->GetStaticMaterials().Add(FStaticMaterial(Pending.Materials[PolygonGroup.GetValue()], SlotName, SlotName));
+      }
+      Mesh->NaniteSettings.bEnabled = ShouldEnableNanite(
+        BuildSettings, Pending.Description.Triangles().Num(), Pending.Materials);
+
+      // Hand the description to the source model and let the batch build
+      // below do the only build, instead of building once here and again
+      // afterwards. Meshes without Nanite get a LOD chain that the build
+      // reduces from LOD 0 with the quadric mesh reduction.
+      const int32 NumLODs = Mesh->NaniteSettings.bEnabled ? 1 : 1 + BuildSettings.LODScreenSizes.Num();
+      Mesh->SetNumSourceModels(NumLODs);
+      FMeshBuildSettings& MeshBuildSettings = Mesh->GetSourceModel(0).BuildSettings;
+      MeshBuildSettings.bRecomputeNormals = false;
+      MeshBuildSettings.bRecomputeTangents = !Pending.bHasTangents;
+      if (Pending.PercentTriangles < 1.0f)
+      {
+        FMeshReductionSettings& ReductionSettings = Mesh->GetSourceModel(0).ReductionSettings;
+        ReductionSettings.PercentTriangles = Pending.PercentTriangles;
+        ReductionSettings.PercentVertices = Pending.PercentTriangles;
+      }
+      if (NumLODs > 1)
+      {
+        Mesh->bAutoComputeLODScreenSize = false;
+        for (int32 LODIndex = 1; LODIndex < NumLODs; ++LODIndex)
+        {
+          FStaticMeshSourceModel& SourceModel = Mesh->GetSourceModel(LODIndex);
+          SourceModel.BuildSettings = MeshBuildSettings;
+          SourceModel.ReductionSettings.PercentTriangles =
+            Pending.PercentTriangles * FMath::Pow(BuildSettings.LODTriangleRatio, (float)LODIndex);
+          SourceModel.ReductionSettings.PercentVertices = SourceModel.ReductionSettings.PercentTriangles;
+          SourceModel.ReductionSettings.BaseLODModel = 0;
+          SourceModel.ScreenSize.Default = BuildSettings.LODScreenSizes[LODIndex - 1];
+        }
+      }
+      Mesh->CreateMeshDescription(0, MoveTemp(Pending.Description));
+      Mesh->CommitMeshDescription(0);
+
+      // A decimated copy for complex collision lives inside the mesh and is
+      // built along with the rest.
+      UStaticMesh* ComplexCollisionMesh = nullptr;
+      if (BuildSettings.Collision == EProceduralMeshCollision::ComplexAsSimple)
+      {
+        ComplexCollisionMesh = Mesh;
+      }
+      else if (Pending.CollisionDescription.Polygons().Num() > 0)
+      {
+        ComplexCollisionMesh = NewObject<UStaticMesh>(Mesh, TEXT("ComplexCollision"));
+        ComplexCollisionMesh->GetStaticMaterials().Add(FStaticMaterial());
+        ComplexCollisionMesh->SetNumSourceModels(1);
+        ComplexCollisionMesh->CreateMeshDescription(0, MoveTemp(Pending.CollisionDescription));
+        ComplexCollisionMesh->CommitMeshDescription(0);
+        MeshesToBuild.Add(ComplexCollisionMesh);
+      }
+
+      // Ensure Mesh has a BodySetup
+      Mesh->CreateBodySetup();
+      UBodySetup* BodySetup = Mesh->GetBodySetup();
+      if (BodySetup)
+      {
+          // Complex queries use the complex collision mesh if there is one,
+          // and the simple shapes otherwise
+          BodySetup->CollisionTraceFlag = ComplexCollisionMesh != nullptr ? CTF_UseComplexAsSimple : CTF_UseSimpleAsComplex;
+          BodySetup->AggGeom = MoveTemp(Pending.SimpleCollision);
+          BodySetup->InvalidatePhysicsData();
+          BodySetup->ClearPhysicsMeshes();
+      }
+      Mesh->NeverStream = false;
+      UProceduralMeshSourceHash::SetHash(Mesh, Pending.ContentHash);
+
+      InOutMeshes[Index] = Mesh;
+      CreatedMeshes.Add(Mesh);
+      ComplexCollisionMeshes.Add(ComplexCollisionMesh);
+      MeshesToBuild.Add(Mesh);
+    }
+
+#if ENGINE_MAJOR_VERSION > 4
+    UStaticMesh::BatchBuild(MeshesToBuild);
+#else
+    for (UStaticMesh* Mesh : MeshesToBuild)
+    {
+      Mesh->Build(false);
+    }
+#endif
+
+    // Finalize meshes and notify the asset registry once everything is built.
+    for (int32 Index = 0; Index < CreatedMeshes.Num(); ++Index)
+    {
+      UStaticMesh* Mesh = CreatedMeshes[Index];
+      Mesh->PostEditChange();
+      Mesh->GetOutermost()->MarkPackageDirty();
+      Mesh->ComplexCollisionMesh = ComplexCollisionMeshes[Index];
+      FAssetRegistryModule::AssetCreated(Mesh);
+      if (BuildSettings.bSavePackages)
+      {
+        UAssetSaveQueueSubsystem::EnqueueOrSave(Mesh->GetOutermost());
+      }
+    }
+  }
+
+  /**
+   * Creates the static meshes of a batch. The inputs of every pending mesh
+   * are hashed, meshes generated before from the same inputs are reused, and
+   * the descriptions and collision of the rest are built in parallel before
+   * the assets are created. The callbacks are called from worker threads.
+   * A mesh whose package repeats one earlier in the batch is skipped with an
+   * error and stays null, since creating it would replace the first mesh
+   * while it is queued for the build.
+   */
+  TArray<UStaticMesh*> CreateStaticMeshes(
+    TArrayView<FPendingStaticMesh> PendingMeshes,
+    const FProceduralMeshBuildSettings& BuildSettings,
+    TFunctionRef<uint64(int32 Index)> HashInput,
+    TFunctionRef<void(int32 Index, FPendingStaticMesh& Pending)> BuildInput)
+  {
+    TBitArray<> IsDuplicate(false, PendingMeshes.Num());
+    TSet<FString> PackageNames;
+    PackageNames.Reserve(PendingMeshes.Num());
+    for (int32 Index = 0; Index < PendingMeshes.Num(); ++Index)
+    {
+      bool bAlreadyInBatch = false;
+      PackageNames.Add(PendingMeshes[Index].PackageName, &bAlreadyInBatch);
+      if (bAlreadyInBatch)
+      {
+        UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Skipping %s, its package %s is already used in this batch"),
+          *PendingMeshes[Index].MeshName.ToString(), *PendingMeshes[Index].PackageName);
+        IsDuplicate[Index] = true;
+      }
+    }
+
+    ParallelFor(PendingMeshes.Num(), [&](int32 Index)
+      {
+        if (!IsDuplicate[Index])
+        {
+          PendingMeshes[Index].ContentHash = HashInput(Index);
+        }
+      });
+
+    TArray<UStaticMesh*> Result;
+    Result.Init(nullptr, PendingMeshes.Num());
+    TArray<int32> ToBuild;
+    ToBuild.Reserve(PendingMeshes.Num());
+    for (int32 Index = 0; Index < PendingMeshes.Num(); ++Index)
+    {
+      const FPendingStaticMesh& Pending = PendingMeshes[Index];
+      if (IsDuplicate[Index])
+      {
+        continue;
+      }
+      if (BuildSettings.bReuseUnchangedMeshes)
+      {
+        Result[Index] = UProceduralMeshSourceHash::FindUnchangedMesh(
+          Pending.PackageName, Pending.MeshName, Pending.ContentHash);
+      }
+      if (Result[Index] == nullptr)
+      {
+        ToBuild.Add(Index);
+      }
+    }
+    const int32 NumReused = PendingMeshes.Num() - ToBuild.Num() - IsDuplicate.CountSetBits();
+    if (NumReused > 0)
+    {
+      UE_LOG(LogCarlaMapGenFunctionLibrary, Log, TEXT("Reused %d of %d unchanged meshes"),
+        NumReused, PendingMeshes.Num());
+    }
+
+    // Mesh descriptions and collision do not touch any UObject, so they are
+    // built on worker threads. Only asset creation needs the game thread.
+    ParallelFor(ToBuild.Num(), [&](int32 BuildIndex)
+      {
+        FPendingStaticMesh& Pending = PendingMeshes[ToBuild[BuildIndex]];
+        BuildInput(ToBuild[BuildIndex], Pending);
+        FProceduralMeshCollision::Build(
+          Pending.Description, BuildSettings, Pending.SimpleCollision, Pending.CollisionDescription);
+      });
+
+    CreateStaticMeshAssets(PendingMeshes, BuildSettings, Result);
+    return Result;
+  }
+
+  /** A static mesh component to merge, gathered on the game thread. */
+  struct FMergeSource
+  {
+    UStaticMeshComponent* Component = nullptr;
+    const FMeshDescription* Description = nullptr;
+
+    /** Relative to the origin of the cell. */
+    FTransform Transform;
+
+    /** Material of each polygon group, with the component's overrides. */
+    TArray<UMaterialInterface*> Materials;
+
+    /** Identifies the mesh and its content, for the content hash. */
+    FString MeshPath;
+    uint64 MeshHash = 0;
+  };
+
+  struct FMergeCell
+  {
+    FIntPoint Cell;
+    FVector Origin;
+    TArray<FMergeSource> Sources;
+  };
+
+  bool GatherMergeSource(UStaticMeshComponent* Component, FMergeSource& OutSource)
+  {
+    UStaticMesh* Mesh = Component->GetStaticMesh();
+    if (Mesh == nullptr ||
+        Component->Mobility == EComponentMobility::Movable ||
+        Component->IsA<UInstancedStaticMeshComponent>())
+    {
+      return false;
+    }
+
+    // Meshes without source data, e.g. cooked ones, cannot be merged.
+    OutSource.Description = Mesh->GetMeshDescription(0);
+    if (OutSource.Description == nullptr)
+    {
+      return false;
+    }
+
+    FStaticMeshConstAttributes Attributes(*OutSource.Description);
+    const auto SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+    OutSource.Materials.Init(nullptr, OutSource.Description->PolygonGroups().GetArraySize());
+    for (const FPolygonGroupID PolygonGroup : OutSource.Description->PolygonGroups().GetElementIDs())
+    {
+      int32 MaterialIndex = Mesh->GetMaterialIndex(SlotNames[PolygonGroup]);
+      if (MaterialIndex == INDEX_NONE)
+      {
+        MaterialIndex = PolygonGroup.GetValue();
+      }
+      OutSource.Materials[PolygonGroup.GetValue()] = Component->GetMaterial(MaterialIndex);
+    }
+
+    const UProceduralMeshSourceHash* SourceHash = Mesh->GetAssetUserData<UProceduralMeshSourceHash>();
+    const FGuid LightingGuid = Mesh->GetLightingGuid();
+    OutSource.Component = Component;
+    OutSource.MeshPath = Mesh->GetPathName();
+    OutSource.MeshHash = HashBytes(&LightingGuid, sizeof(LightingGuid), SourceHash != nullptr ? SourceHash->Hash : 0);
+    return true;
+  }
+
+  uint64 HashMergeCell(const FMergeCell& Cell, uint64 Hash)
+  {
+    for (const FMergeSource& Source : Cell.Sources)
+    {
+      const FMatrix Matrix = Source.Transform.ToMatrixWithScale();
+      Hash = HashBytes(&Matrix, sizeof(Matrix), Hash);
+      Hash = HashBytes(*Source.MeshPath, Source.MeshPath.Len() * sizeof(TCHAR), Hash);
+      Hash = HashBytes(&Source.MeshHash, sizeof(Source.MeshHash), Hash);
+      for (const UMaterialInterface* Material : Source.Materials)
+      {
+        const FString MaterialPath = Material != nullptr ? Material->GetPathName() : FString();
+        Hash = HashBytes(*MaterialPath, MaterialPath.Len() * sizeof(TCHAR), Hash);
+      }
+    }
+    return Hash;
+  }
+
+  /** Lists of integers stored back to back, like a sparse matrix in CSR form. */
+  struct FCompressedRows
+  {
+    /** Where each row starts in Values, plus the end of the last row. */
+    TArray<int32> Offsets;
+    TArray<int32> Values;
+
+    TConstArrayView<int32> GetRow(int32 Row) const
+    {
+      return TConstArrayView<int32>(Values.GetData() + Offsets[Row], Offsets[Row + 1] - Offsets[Row]);
+    }
+
+    /** Sizes the rows from RowSizes, which the values are then written into. */
+    void SetRowSizes(TConstArrayView<int32> RowSizes)
+    {
+      Offsets.SetNumUninitialized(RowSizes.Num() + 1);
+      Offsets[0] = 0;
+      for (int32 Row = 0; Row < RowSizes.Num(); ++Row)
+      {
+        Offsets[Row + 1] = Offsets[Row] + RowSizes[Row];
+      }
+      Values.SetNumUninitialized(Offsets.Last());
+    }
+  };
+
+  /** The distinct vertices that share a triangle with each vertex. */
+  FCompressedRows BuildVertexAdjacency(int32 NumVertices, const TArray<int32>& Indices)
+  {
+    const int32 NumTriangles = Indices.Num() / 3;
+    auto IsValidTriangle = [&](int32 TriIdx)
+    {
+      return (uint32)Indices[TriIdx * 3] < (uint32)NumVertices &&
+        (uint32)Indices[TriIdx * 3 + 1] < (uint32)NumVertices &&
+        (uint32)Indices[TriIdx * 3 + 2] < (uint32)NumVertices;
+    };
+
+    // Every corner adds its two triangle neighbours, duplicates included.
+    TArray<int32> RowSizes;
+    RowSizes.SetNumZeroed(NumVertices);
+    int32 NumSkipped = 0;
+    for (int32 TriIdx = 0; TriIdx < NumTriangles; ++TriIdx)
+    {
+      if (!IsValidTriangle(TriIdx))
+      {
+        ++NumSkipped;
+        continue;
+      }
+      for (int32 Corner = 0; Corner < 3; ++Corner)
+      {
+        RowSizes[Indices[TriIdx * 3 + Corner]] += 2;
+      }
+    }
+    if (NumSkipped > 0)
+    {
+      UE_LOG(LogCarlaMapGenFunctionLibrary, Warning, TEXT("Skipping %d triangles with a vertex out of range"), NumSkipped);
+    }
+    FCompressedRows Edges;
+    Edges.SetRowSizes(RowSizes);
+    TArray<int32> Fill(Edges.Offsets.GetData(), NumVertices);
+    for (int32 TriIdx = 0; TriIdx < NumTriangles; ++TriIdx)
+    {
+      if (!IsValidTriangle(TriIdx))
+      {
+        continue;
+      }
+      for (int32 Corner = 0; Corner < 3; ++Corner)
+      {
+        const int32 Vertex = Indices[TriIdx * 3 + Corner];
+        Edges.Values[Fill[Vertex]++] = Indices[TriIdx * 3 + (Corner + 1) % 3];
+        Edges.Values[Fill[Vertex]++] = Indices[TriIdx * 3 + (Corner + 2) % 3];
+      }
+    }
+
+    // Sort and deduplicate each row in place, then pack the rows.
+    ParallelFor(NumVertices, [&](int32 Vertex)
+      {
+        int32* Row = Edges.Values.GetData() + Edges.Offsets[Vertex];
+        const int32 Num = Edges.Offsets[Vertex + 1] - Edges.Offsets[Vertex];
+        Algo::Sort(TArrayView<int32>(Row, Num));
+        int32 Unique = 0;
+        for (int32 Index = 0; Index < Num; ++Index)
+        {
+          if (Row[Index] != Vertex && (Unique == 0 || Row[Unique - 1] != Row[Index]))
+          {
+            Row[Unique++] = Row[Index];
+          }
+        }
+        RowSizes[Vertex] = Unique;
+      });
+    FCompressedRows Adjacency;
+    Adjacency.SetRowSizes(RowSizes);
+    ParallelFor(NumVertices, [&](int32 Vertex)
+      {
+        FMemory::Memcpy(
+          Adjacency.Values.GetData() + Adjacency.Offsets[Vertex],
+          Edges.Values.GetData() + Edges.Offsets[Vertex],
+          RowSizes[Vertex] * sizeof(int32));
+      });
+    return Adjacency;
+  }
+
+  /**
+   * The vertices within Depth edges of each vertex, not counting itself.
+   * The rings are collected twice, once to size the rows and once to fill
+   * them, which is cheaper than holding an array per vertex.
+   */
+  FCompressedRows BuildVertexRings(const FCompressedRows& Adjacency, int32 Depth)
+  {
+    const int32 NumVertices = Adjacency.Offsets.Num() - 1;
+
+    // Rings are small, so a linear search beats a set.
+    using FRing = TArray<int32, TInlineAllocator<64>>;
+    auto CollectRing = [&](int32 Vertex, FRing& OutRing)
+    {
+      OutRing.Reset();
+      OutRing.Add(Vertex);
+      int32 LevelStart = 0;
+      for (int32 Level = 0; Level < Depth && LevelStart < OutRing.Num(); ++Level)
+      {
+        const int32 LevelEnd = OutRing.Num();
+        for (int32 Index = LevelStart; Index < LevelEnd; ++Index)
+        {
+          for (int32 Neighbor : Adjacency.GetRow(OutRing[Index]))
+          {
+            if (!OutRing.Contains(Neighbor))
+            {
+              OutRing.Add(Neighbor);
+            }
+          }
+        }
+        LevelStart = LevelEnd;
+      }
+      OutRing.RemoveAtSwap(0, 1, EAllowShrinking::No);
+    };
+
+    TArray<int32> RowSizes;
+    RowSizes.SetNumUninitialized(NumVertices);
+    ParallelFor(NumVertices, [&](int32 Vertex)
+      {
+        FRing Ring;
+        CollectRing(Vertex, Ring);
+        RowSizes[Vertex] = Ring.Num();
+      });
+
+    FCompressedRows Rings;
+    Rings.SetRowSizes(RowSizes);
+    ParallelFor(NumVertices, [&](int32 Vertex)
+      {
+        FRing Ring;
+        CollectRing(Vertex, Ring);
+        FMemory::Memcpy(Rings.Values.GetData() + Rings.Offsets[Vertex], Ring.GetData(), Ring.Num() * sizeof(int32));
+      });
+    return Rings;
+  }
+
+  /** Appends the sources of Cell into one description with a polygon group per material. */
+  void MergeCellDescription(const FMergeCell& Cell, FPendingStaticMesh& OutPending)
+  {
+    OutPending.Description = CreateEmptyMeshDescription();
+    OutPending.Materials.Reset();
+
+    // Not every source keeps its tangents in its description.
+    OutPending.bHasTangents = false;
+
+    TMap<UMaterialInterface*, FPolygonGroupID> MaterialGroups;
+    for (const FMergeSource& Source : Cell.Sources)
+    {
+      FStaticMeshOperations::FAppendSettings AppendSettings;
+      AppendSettings.MeshTransform = Source.Transform;
+      AppendSettings.PolygonGroupsDelegate = FAppendPolygonGroupsDelegate::CreateLambda(
+        [&](const FMeshDescription& SourceMesh, FMeshDescription& TargetMesh, PolygonGroupMap& RemapPolygonGroups)
+        {
+          for (const FPolygonGroupID PolygonGroup : SourceMesh.PolygonGroups().GetElementIDs())
+          {
+            UMaterialInterface* Material = Source.Materials[PolygonGroup.GetValue()];
+            FPolygonGroupID* TargetGroup = MaterialGroups.Find(Material);
+            if (TargetGroup == nullptr)
+            {
+              TargetGroup = &MaterialGroups.Add(Material, CreateMaterialPolygonGroup(TargetMesh, Material));
+              OutPending.Materials.Add(Material);
+            }
+            RemapPolygonGroups.Add(PolygonGroup, *TargetGroup);
+          }
+        });
+      FStaticMeshOperations::AppendMeshDescription(*Source.Description, OutPending.Description, AppendSettings);
+    }
+  }
+}
+
 FMeshDescription UMapGenFunctionLibrary::BuildMeshDescriptionFromData(
   const FProceduralCustomMesh& Data,
   const TArray<FProcMeshTangent>& ParamTangents,
-  UMaterialInstance* MaterialInstance  )
+  UMaterialInstance* MaterialInstance,
+  const FProceduralMeshBuildSettings& BuildSettings)
 {
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::BuildMeshDescriptionFromData);
 
-  int32 VertexCount = Data.Vertices.Num();
-  int32 VertexInstanceCount = Data.Triangles.Num();
-  int32 PolygonCount = Data.Vertices.Num()/3;
-
-	FMeshDescription MeshDescription;
-  FStaticMeshAttributes AttributeGetter(MeshDescription);
-  AttributeGetter.Register();
-
-  auto PolygonGroupNames = AttributeGetter.GetPolygonGroupMaterialSlotNames();
-  auto VertexPositions = AttributeGetter.GetVertexPositions();
-  auto Tangents = AttributeGetter.GetVertexInstanceTangents();
-  auto BinormalSigns = AttributeGetter.GetVertexInstanceBinormalSigns();
-  auto Normals = AttributeGetter.GetVertexInstanceNormals();
-  auto Colors = AttributeGetter.GetVertexInstanceColors();
-  auto UVs = AttributeGetter.GetVertexInstanceUVs();
-
-  // Calculate the totals for each ProcMesh element type
-  FPolygonGroupID PolygonGroupForSection;
-  MeshDescription.ReserveNewVertices(VertexCount);
-  MeshDescription.ReserveNewVertexInstances(VertexInstanceCount);
-  MeshDescription.ReserveNewPolygons(PolygonCount);
-  MeshDescription.ReserveNewEdges(PolygonCount * 2);
-  UVs.SetNumIndices(4);
+	FMeshDescription MeshDescription = CreateEmptyMeshDescription();
+  const FCustomMeshReader Reader{ Data, ParamTangents };
+  if (!ValidateTriangles(Reader))
+  {
+    return MeshDescription;
+  }
 
   // Create Materials
-  TMap<UMaterialInterface*, FPolygonGroupID> UniqueMaterials;
-	const int32 NumSections = 1;
-	UniqueMaterials.Reserve(1);
-  FPolygonGroupID NewPolygonGroup = MeshDescription.CreatePolygonGroup();
-
-  if( MaterialInstance != nullptr ){
-    UMaterialInterface *Material = MaterialInstance;
-    UniqueMaterials.Add(Material, NewPolygonGroup);
-    PolygonGroupNames[NewPolygonGroup] = Material->GetFName();
-  }else{
-    UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("MaterialInstance is nullptr"));
+  const FPolygonGroupID NewPolygonGroup = CreateMaterialPolygonGroup(MeshDescription, MaterialInstance);
+  AppendMeshSection(MeshDescription, Reader, NewPolygonGroup, BuildSettings);
+  if (!Reader.HasTangents())
+  {
+    ComputeMissingTangents(MeshDescription);
   }
-  PolygonGroupForSection = NewPolygonGroup;
+  return MeshDescription;
+}
 
+FMeshDescription UMapGenFunctionLibrary::BuildMeshDescriptionFromCompact(
+  const FProceduralCompactMesh& Data,
+  UMaterialInterface* Material,
+  const FProceduralMeshBuildSettings& BuildSettings)
+{
+  return BuildMeshDescriptionFromCompact(Data.GetView(), Material, BuildSettings);
+}
 
+FMeshDescription UMapGenFunctionLibrary::BuildMeshDescriptionFromCompact(
+  const FProceduralCompactMeshView& Data,
+  UMaterialInterface* Material,
+  const FProceduralMeshBuildSettings& BuildSettings)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::BuildMeshDescriptionFromCompact);
 
-  // Create the vertex
-  int32 NumVertex = Data.Vertices.Num();
-  TMap<int32, FVertexID> VertexIndexToVertexID;
-  VertexIndexToVertexID.Reserve(NumVertex);
-  for (int32 VertexIndex = 0; VertexIndex < NumVertex; ++VertexIndex)
+  FMeshDescription MeshDescription = CreateEmptyMeshDescription();
+  const FCompactMeshReader Reader{ Data };
+  if (!ValidateTriangles(Reader))
   {
-    auto& Vert = Data.Vertices[VertexIndex];
-    const FVertexID VertexID = MeshDescription.CreateVertex();
-    VertexPositions[VertexID] = V3(Vert);
-    VertexIndexToVertexID.Add(VertexIndex, VertexID);
+    return MeshDescription;
   }
 
-  // Create the VertexInstance
-  int32 NumIndices = Data.Triangles.Num();
-  int32 NumTri = NumIndices / 3;
-  TMap<int32, FVertexInstanceID> IndiceIndexToVertexInstanceID;
-  IndiceIndexToVertexInstanceID.Reserve(NumVertex);
-  for (int32 IndiceIndex = 0; IndiceIndex < NumIndices; IndiceIndex++)
+  const FPolygonGroupID NewPolygonGroup = CreateMaterialPolygonGroup(MeshDescription, Material);
+  AppendMeshSection(MeshDescription, Reader, NewPolygonGroup, BuildSettings);
+  if (!Reader.HasTangents())
   {
-    const int32 VertexIndex = Data.Triangles[IndiceIndex];
-    const FVertexID VertexID = VertexIndexToVertexID[VertexIndex];
-    const FVertexInstanceID VertexInstanceID =
-    MeshDescription.CreateVertexInstance(VertexID);
-    IndiceIndexToVertexInstanceID.Add(IndiceIndex, VertexInstanceID);
-    Normals[VertexInstanceID] = V3(Data.Normals[VertexIndex]);
+    ComputeMissingTangents(MeshDescription);
+  }
+  return MeshDescription;
+}
 
-    if(ParamTangents.Num() == Data.Vertices.Num())
-    {
-      Tangents[VertexInstanceID] = V3(ParamTangents[VertexIndex].TangentX);
-      BinormalSigns[VertexInstanceID] =
-        ParamTangents[VertexIndex].bFlipTangentY ? -1.f : 1.f;
-    }else{
+FMeshDescription UMapGenFunctionLibrary::BuildMeshDescriptionFromSections(
+  const TArray<FProceduralMeshSection>& Sections,
+  const FProceduralMeshBuildSettings& BuildSettings,
+  TArray<UMaterialInterface*>* OutMaterials)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::BuildMeshDescriptionFromSections);
 
-    }
-    Colors[VertexInstanceID] = FLinearColor(0,0,0);
-    if(Data.UV0.Num() == Data.Vertices.Num())
+  FMeshDescription MeshDescription = CreateEmptyMeshDescription();
+  for (const FProceduralMeshSection& Section : Sections)
+  {
+    if (!ReadSection(Section, [](const auto& Reader) { return ValidateTriangles(Reader); }))
     {
-      UVs.Set(VertexInstanceID, 0, V2(Data.UV0[VertexIndex]));
-    }else{
-      UVs.Set(VertexInstanceID, 0, V2(0,0));
+      return CreateEmptyMeshDescription();
     }
-    UVs.Set(VertexInstanceID, 1, V2(0,0));
-    UVs.Set(VertexInstanceID, 2, V2(0,0));
-    UVs.Set(VertexInstanceID, 3, V2(0,0));
   }
 
-  for (int32 TriIdx = 0; TriIdx < NumTri; TriIdx++)
+  // Sections sharing a material share a polygon group, and with it a draw call.
+  TArray<UMaterialInterface*> Materials;
+  TArray<FPolygonGroupID> PolygonGroups;
+  for (const FProceduralMeshSection& Section : Sections)
   {
-    FVertexID VertexIndexes[3];
-    TArray<FVertexInstanceID> VertexInstanceIDs;
-    VertexInstanceIDs.SetNum(3);
-
-    for (int32 CornerIndex = 0; CornerIndex < 3; ++CornerIndex)
+    int32 MaterialIndex = Materials.Find(Section.Material);
+    if (MaterialIndex == INDEX_NONE)
     {
-      const int32 IndiceIndex = (TriIdx * 3) + CornerIndex;
-      const int32 VertexIndex = Data.Triangles[IndiceIndex];
-      VertexIndexes[CornerIndex] = VertexIndexToVertexID[VertexIndex];
-      VertexInstanceIDs[CornerIndex] =
-        IndiceIndexToVertexInstanceID[IndiceIndex];
+      MaterialIndex = Materials.Add(Section.Material);
+      PolygonGroups.Add(CreateMaterialPolygonGroup(MeshDescription, Section.Material));
     }
+    ReadSection(Section, [&](const auto& Reader)
+      {
+        AppendMeshSection(MeshDescription, Reader, PolygonGroups[MaterialIndex], BuildSettings);
+      });
+  }
 
-    // Insert a polygon into the mesh
-    MeshDescription.CreatePolygon(NewPolygonGroup, VertexInstanceIDs);
-
+  // Tangents are computed for the whole description, so sections that came
+  // with their own get them recomputed too, as the build used to do.
+  if (!HaveTangents(Sections))
+  {
+    ComputeMissingTangents(MeshDescription);
   }
 
+  if (OutMaterials != nullptr)
+  {
+    *OutMaterials = MoveTemp(Materials);
+  }
   return MeshDescription;
 }
 
@@ -159,64 +1357,461 @@ UStaticMesh* UMapGenFunctionLibrary::CreateMesh(
     FString FolderName,
     FName MeshName)
 {
-  IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+  return CreateMeshWithSettings(Data, ParamTangents, MaterialInstance, MapName, FolderName, MeshName,
+    FProceduralMeshBuildSettings());
+}
+
+UStaticMesh* UMapGenFunctionLibrary::CreateMeshWithSettings(
+    const FProceduralCustomMesh& Data,
+    const TArray<FProcMeshTangent>& ParamTangents,
+    UMaterialInstance* MaterialInstance,
+    FString MapName,
+    FString FolderName,
+    FName MeshName,
+    const FProceduralMeshBuildSettings& BuildSettings)
+{
+  FPendingStaticMesh Pending;
+  Pending.PackageName = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName) + FolderName + "/" + MeshName.ToString();
+  Pending.MeshName = MeshName;
+  return CreateStaticMeshes(MakeArrayView(&Pending, 1), BuildSettings,
+    [&](int32)
+    {
+      return HashSection(Data, ParamTangents, MaterialInstance, HashBuildSettings(BuildSettings));
+    },
+    [&](int32, FPendingStaticMesh& OutPending)
+    {
+      OutPending.Description = BuildMeshDescriptionFromData(Data,ParamTangents, MaterialInstance, BuildSettings);
+      OutPending.Materials.Add(MaterialInstance);
+      OutPending.bHasTangents = true;
+    })[0];
+}
+
+UStaticMesh* UMapGenFunctionLibrary::CreateMeshFromCompact(
+    const FProceduralCompactMesh& Data,
+    UMaterialInterface* Material,
+    FString MapName,
+    FString FolderName,
+    FName MeshName,
+    const FProceduralMeshBuildSettings& BuildSettings)
+{
+  FPendingStaticMesh Pending;
+  Pending.PackageName = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName) + FolderName + "/" + MeshName.ToString();
+  Pending.MeshName = MeshName;
+  return CreateStaticMeshes(MakeArrayView(&Pending, 1), BuildSettings,
+    [&](int32)
+    {
+      return HashCompactSection(Data.GetView(), Material, HashBuildSettings(BuildSettings));
+    },
+    [&](int32, FPendingStaticMesh& OutPending)
+    {
+      OutPending.Description = BuildMeshDescriptionFromCompact(Data, Material, BuildSettings);
+      OutPending.Materials.Add(Material);
+      OutPending.bHasTangents = true;
+    })[0];
+}
+
+FProceduralCompactMesh UMapGenFunctionLibrary::MakeCompactMesh(
+    const FProceduralCustomMesh& Data,
+    const TArray<FProcMeshTangent>& ParamTangents)
+{
+  return FProceduralCompactMesh::FromCustomMesh(Data, ParamTangents);
+}
+
+UStaticMesh* UMapGenFunctionLibrary::CreateMeshFromSections(
+    const TArray<FProceduralMeshSection>& Sections,
+    FString MapName,
+    FString FolderName,
+    FName MeshName,
+    const FProceduralMeshBuildSettings& BuildSettings)
+{
+  FPendingStaticMesh Pending;
+  Pending.PackageName = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName) + FolderName + "/" + MeshName.ToString();
+  Pending.MeshName = MeshName;
+  return CreateStaticMeshes(MakeArrayView(&Pending, 1), BuildSettings,
+    [&](int32)
+    {
+      return HashSections(Sections, BuildSettings);
+    },
+    [&](int32, FPendingStaticMesh& OutPending)
+    {
+      OutPending.Description = BuildMeshDescriptionFromSections(Sections, BuildSettings, &OutPending.Materials);
+      OutPending.bHasTangents = true;
+    })[0];
+}
+
+TArray<UStaticMesh*> UMapGenFunctionLibrary::CreateMeshes(
+    const TArray<FProceduralMeshBatchEntry>& Entries,
+    FString MapName,
+    const FProceduralMeshBuildSettings& BuildSettings)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::CreateMeshes);
+
+  const FString MapContentPath = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName);
+  TArray<FPendingStaticMesh> PendingMeshes;
+  PendingMeshes.SetNum(Entries.Num());
+  for (int32 Index = 0; Index < Entries.Num(); ++Index)
+  {
+    PendingMeshes[Index].PackageName = MapContentPath + Entries[Index].FolderName + "/" + Entries[Index].MeshName.ToString();
+    PendingMeshes[Index].MeshName = Entries[Index].MeshName;
+  }
+
+  return CreateStaticMeshes(PendingMeshes, BuildSettings,
+    [&](int32 Index)
+    {
+      return HashSections(Entries[Index].Sections, BuildSettings);
+    },
+    [&](int32 Index, FPendingStaticMesh& OutPending)
+    {
+      OutPending.Description = BuildMeshDescriptionFromSections(Entries[Index].Sections, BuildSettings, &OutPending.Materials);
+      OutPending.bHasTangents = true;
+    });
+}
+
+TArray<UStaticMesh*> UMapGenFunctionLibrary::CreateMeshesFromFile(
+    FString Filename,
+    UMaterialInterface* DefaultMaterial,
+    FString MapName,
+    FString FolderName,
+    const FProceduralMeshBuildSettings& BuildSettings)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::CreateMeshesFromFile);
 
-  UStaticMesh::FBuildMeshDescriptionsParams Params;
-  Params.bBuildSimpleCollision = false;
+  const TUniquePtr<FProceduralMeshFile> File = FProceduralMeshFile::Open(Filename);
+  if (!File.IsValid())
+  {
+    return {};
+  }
 
-  FString PackageName = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName) + FolderName + "/" + MeshName.ToString();
+  // Materials are loaded up front, on the game thread.
+  TMap<FString, UMaterialInterface*> LoadedMaterials;
+  TArray<UMaterialInterface*> Materials;
+  Materials.SetNum(File->NumMeshes());
+  for (int32 Index = 0; Index < File->NumMeshes(); ++Index)
+  {
+    const FString& MaterialPath = File->GetMaterialPath(Index);
+    if (MaterialPath.IsEmpty())
+    {
+      Materials[Index] = DefaultMaterial;
+      continue;
+    }
+    UMaterialInterface** Loaded = LoadedMaterials.Find(MaterialPath);
+    if (Loaded == nullptr)
+    {
+      Loaded = &LoadedMaterials.Add(MaterialPath, LoadObject<UMaterialInterface>(nullptr, *MaterialPath));
+      if (*Loaded == nullptr)
+      {
+        UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Could not load material %s"), *MaterialPath);
+      }
+    }
+    Materials[Index] = *Loaded != nullptr ? *Loaded : DefaultMaterial;
+  }
 
-  if (!PlatformFile.DirectoryExists(*PackageName))
+  const FString MapContentPath = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName);
+  TArray<FPendingStaticMesh> PendingMeshes;
+  PendingMeshes.SetNum(File->NumMeshes());
+  for (int32 Index = 0; Index < File->NumMeshes(); ++Index)
   {
-    //PlatformFile.CreateDirectory(*PackageName);
+    PendingMeshes[Index].PackageName = MapContentPath + FolderName + "/" + File->GetMeshName(Index);
+    PendingMeshes[Index].MeshName = FName(*File->GetMeshName(Index));
+    if (!FPackageName::IsValidLongPackageName(PendingMeshes[Index].PackageName))
+    {
+      UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Invalid package name %s for %s"),
+        *PendingMeshes[Index].PackageName, *Filename);
+      return {};
+    }
   }
 
+  return CreateStaticMeshes(PendingMeshes, BuildSettings,
+    [&](int32 Index)
+    {
+      return HashCompactSection(File->GetMesh(Index), Materials[Index], HashBuildSettings(BuildSettings));
+    },
+    [&](int32 Index, FPendingStaticMesh& OutPending)
+    {
+      OutPending.Description = BuildMeshDescriptionFromCompact(File->GetMesh(Index), Materials[Index], BuildSettings);
+      OutPending.Materials.Add(Materials[Index]);
+      OutPending.bHasTangents = true;
+    });
+}
 
-  FMeshDescription Description = BuildMeshDescriptionFromData(Data,ParamTangents, MaterialInstance);
+TArray<UStaticMesh*> UMapGenFunctionLibrary::CreateChunkedMeshes(
+    const TArray<FProceduralMeshSection>& Sections,
+    FString MapName,
+    FString FolderName,
+    FName MeshName,
+    float CellSize,
+    const FProceduralMeshBuildSettings& BuildSettings,
+    TArray<FVector>& OutOrigins)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::CreateChunkedMeshes);
 
-  if (Description.Polygons().Num() > 0)
+  OutOrigins.Reset();
+  if (CellSize <= 0.0f)
   {
-    UPackage* Package = CreatePackage(*PackageName);
-    check(Package);
-    UStaticMesh* Mesh = NewObject<UStaticMesh>( Package, MeshName, RF_Public | RF_Standalone);
+    UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Invalid cell size %f for %s"), CellSize, *MeshName.ToString());
+    return {};
+  }
+
+  TArray<TArray<FProceduralMeshChunk>> SectionChunks;
+  SectionChunks.SetNum(Sections.Num());
+  ParallelFor(Sections.Num(), [&](int32 SectionIndex)
+    {
+      const FProceduralMeshSection& Section = Sections[SectionIndex];
+      if (Section.CompactMesh.NumVertices() == 0)
+      {
+        SectionChunks[SectionIndex] = FProceduralMeshChunking::Split(Section.Mesh, Section.Tangents, CellSize);
+        return;
+      }
 
-    Mesh->InitResources();
+      // Clipping works on full precision data, each chunk is small again.
+      TArray<FProcMeshTangent> Tangents;
+      const FProceduralCustomMesh Mesh = Section.CompactMesh.ToCustomMesh(&Tangents);
+      SectionChunks[SectionIndex] = FProceduralMeshChunking::Split(Mesh, Tangents, CellSize);
+    });
 
-    Mesh->SetLightingGuid(FGuid::NewGuid());
-    Mesh->GetStaticMaterials().Add(FStaticMaterial(MaterialInstance));
-    Mesh->NaniteSettings.bEnabled = true;
-    Mesh->BuildFromMeshDescriptions({ &Description }, Params);
-    // Ensure Mesh has a BodySetup
-    Mesh->CreateBodySetup();
-    UBodySetup* BodySetup = Mesh->GetBodySetup();
-    if (BodySetup)
+  // One entry per cell, with a section for every input section in it.
+  TMap<FIntPoint, int32> CellEntries;
+  TArray<FProceduralMeshBatchEntry> Entries;
+  for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); ++SectionIndex)
+  {
+    for (FProceduralMeshChunk& Chunk : SectionChunks[SectionIndex])
     {
-        // Set to use complex as simple collision
-        BodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
-        BodySetup->InvalidatePhysicsData();
-        BodySetup->ClearPhysicsMeshes();
+      int32& EntryIndex = CellEntries.FindOrAdd(Chunk.Cell, INDEX_NONE);
+      if (EntryIndex == INDEX_NONE)
+      {
+        EntryIndex = Entries.AddDefaulted();
+        Entries[EntryIndex].FolderName = FolderName;
+        Entries[EntryIndex].MeshName = FName(*FString::Printf(TEXT("%s_%d_%d"), *MeshName.ToString(), Chunk.Cell.X, Chunk.Cell.Y));
+        OutOrigins.Add(Chunk.Origin);
+      }
+      FProceduralMeshSection& Section = Entries[EntryIndex].Sections.AddDefaulted_GetRef();
+      Section.Mesh = MoveTemp(Chunk.Mesh);
+      Section.Tangents = MoveTemp(Chunk.Tangents);
+      Section.Material = Sections[SectionIndex].Material;
     }
-    // Build mesh from source
-    Mesh->NeverStream = false;
-    TArray<UObject*> CreatedAssets;
-    CreatedAssets.Add(Mesh);
+  }
 
-    // Notify asset registry of new asset
-    FAssetRegistryModule::AssetCreated(Mesh);
-    //UPackage::SavePackage(Package, Mesh, EObjectFlags::RF_Public | EObjectFlags::RF_Standalone, *(MeshName.ToString()), GError, nullptr, true, true, SAVE_NoError);
-#if ENGINE_MAJOR_VERSION > 4
-    TArray<UStaticMesh*> MeshToEnableNanite;
-    MeshToEnableNanite.Add(Mesh);
-    UStaticMesh::BatchBuild(MeshToEnableNanite);
+  UE_LOG(LogCarlaMapGenFunctionLibrary, Log, TEXT("Split %s into %d cells"), *MeshName.ToString(), Entries.Num());
+  return CreateMeshes(Entries, MapName, BuildSettings);
+}
+
+TArray<AStaticMeshActor*> UMapGenFunctionLibrary::SpawnChunkActors(
+    UObject* WorldContextObject,
+    const TArray<UStaticMesh*>& Meshes,
+    const TArray<FVector>& Origins,
+    FName FolderPath)
+{
+  TArray<AStaticMeshActor*> Actors;
+  UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+  if (World == nullptr || Meshes.Num() != Origins.Num())
+  {
+    UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Invalid world or mismatched meshes and origins in SpawnChunkActors"));
+    return Actors;
+  }
+
+  Actors.Reserve(Meshes.Num());
+  for (int32 Index = 0; Index < Meshes.Num(); ++Index)
+  {
+    if (Meshes[Index] == nullptr)
+    {
+      continue;
+    }
+
+    AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(Origins[Index], FRotator::ZeroRotator);
+    if (Actor == nullptr)
+    {
+      UE_LOG(LogCarlaMapGenFunctionLibrary, Error, TEXT("Could not spawn an actor for %s"), *Meshes[Index]->GetName());
+      continue;
+    }
+    Actor->GetStaticMeshComponent()->SetStaticMesh(Meshes[Index]);
+#if WITH_EDITOR
+    Actor->SetActorLabel(Meshes[Index]->GetName());
+    Actor->SetFolderPath(FolderPath);
+#if ENGINE_MAJOR_VERSION >= 5
+    Actor->SetIsSpatiallyLoaded(true);
 #endif
-    // Finalize mesh
-    Mesh->Build(false); // Rebuilds mesh data, optionally pass true to mark as async
-    Mesh->PostEditChange();
-    Package->MarkPackageDirty();
-    Mesh->ComplexCollisionMesh = Mesh;
-    return Mesh;
-  }
-  return nullptr;
+#endif
+    Actors.Add(Actor);
+  }
+  return Actors;
+}
+
+TArray<AStaticMeshActor*> UMapGenFunctionLibrary::MergeActorsByCell(
+    const TArray<AActor*>& Actors,
+    FString MapName,
+    FString FolderName,
+    FName MeshName,
+    const FProceduralMeshMergeSettings& MergeSettings,
+    const FProceduralMeshBuildSettings& BuildSettings)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::MergeActorsByCell);
+
+  // Gather the components and everything the merge reads from UObjects.
+  UWorld* World = nullptr;
+  TMap<FIntPoint, int32> CellIndices;
+  TArray<FMergeCell> Cells;
+  // An actor listed twice must not add its geometry twice.
+  TSet<AActor*> VisitedActors;
+  for (AActor* Actor : Actors)
+  {
+    bool bAlreadyVisited = false;
+    VisitedActors.Add(Actor, &bAlreadyVisited);
+    if (Actor == nullptr || bAlreadyVisited)
+    {
+      continue;
+    }
+    World = Actor->GetWorld();
+
+    TInlineComponentArray<UStaticMeshComponent*> Components(Actor);
+    for (UStaticMeshComponent* Component : Components)
+    {
+      FMergeSource Source;
+      if (!GatherMergeSource(Component, Source))
+      {
+        continue;
+      }
+
+      const FIntPoint Cell = FProceduralMeshChunking::GetCell(Component->Bounds.Origin, MergeSettings.CellSize);
+      int32& CellIndex = CellIndices.FindOrAdd(Cell, INDEX_NONE);
+      if (CellIndex == INDEX_NONE)
+      {
+        CellIndex = Cells.Num();
+        FMergeCell& NewCell = Cells.AddDefaulted_GetRef();
+        NewCell.Cell = Cell;
+        NewCell.Origin = FProceduralMeshChunking::GetCellOrigin(Cell, MergeSettings.CellSize);
+      }
+      Source.Transform = Component->GetComponentTransform();
+      Source.Transform.AddToTranslation(-Cells[CellIndex].Origin);
+      Cells[CellIndex].Sources.Add(MoveTemp(Source));
+    }
+  }
+
+  TArray<AStaticMeshActor*> Result;
+  if (World == nullptr || Cells.Num() == 0)
+  {
+    UE_LOG(LogCarlaMapGenFunctionLibrary, Warning, TEXT("No static mesh components to merge for %s"), *MeshName.ToString());
+    return Result;
+  }
+
+  const FString MapContentPath = UGenerationPathsHelper::GetMapContentDirectoryPath(MapName);
+  auto MakePendingMeshes = [&](const TCHAR* Suffix, float PercentTriangles)
+  {
+    TArray<FPendingStaticMesh> PendingMeshes;
+    PendingMeshes.SetNum(Cells.Num());
+    for (int32 Index = 0; Index < Cells.Num(); ++Index)
+    {
+      const FString Name = FString::Printf(TEXT("%s_%d_%d%s"), *MeshName.ToString(), Cells[Index].Cell.X, Cells[Index].Cell.Y, Suffix);
+      PendingMeshes[Index].PackageName = MapContentPath + FolderName + "/" + Name;
+      PendingMeshes[Index].MeshName = FName(*Name);
+      PendingMeshes[Index].PercentTriangles = PercentTriangles;
+    }
+    return PendingMeshes;
+  };
+  auto HashCell = [&](int32 Index, const FProceduralMeshBuildSettings& Settings, float PercentTriangles)
+  {
+    return HashMergeCell(Cells[Index], HashBytes(&PercentTriangles, sizeof(PercentTriangles), HashBuildSettings(Settings)));
+  };
+
+  TArray<FPendingStaticMesh> MergedPending = MakePendingMeshes(TEXT(""), 1.0f);
+  const TArray<UStaticMesh*> MergedMeshes = CreateStaticMeshes(MergedPending, BuildSettings,
+    [&](int32 Index)
+    {
+      return HashCell(Index, BuildSettings, 1.0f);
+    },
+    [&](int32 Index, FPendingStaticMesh& OutPending)
+    {
+      MergeCellDescription(Cells[Index], OutPending);
+    });
+
+  // Proxies are only seen from afar, so they go without Nanite, LODs or
+  // collision.
+  TArray<UStaticMesh*> ProxyMeshes;
+  ProxyMeshes.Init(nullptr, Cells.Num());
+  if (MergeSettings.ProxyDistance > 0.0f)
+  {
+    FProceduralMeshBuildSettings ProxySettings = BuildSettings;
+    ProxySettings.Nanite = EProceduralMeshNanite::Disabled;
+    ProxySettings.LODScreenSizes.Reset();
+    ProxySettings.Collision = EProceduralMeshCollision::NoCollision;
+    TArray<FPendingStaticMesh> ProxyPending = MakePendingMeshes(TEXT("_Proxy"), MergeSettings.ProxyTriangleRatio);
+    ProxyMeshes = CreateStaticMeshes(ProxyPending, ProxySettings,
+      [&](int32 Index)
+      {
+        return HashCell(Index, ProxySettings, MergeSettings.ProxyTriangleRatio);
+      },
+      [&](int32 Index, FPendingStaticMesh& OutPending)
+      {
+        MergeCellDescription(Cells[Index], OutPending);
+      });
+  }
+
+  const FName FolderPath(*(FolderName / MeshName.ToString()));
+  for (int32 Index = 0; Index < Cells.Num(); ++Index)
+  {
+    if (MergedMeshes[Index] == nullptr)
+    {
+      continue;
+    }
+
+    const TArray<AStaticMeshActor*> Spawned = SpawnChunkActors(World, { MergedMeshes[Index] }, { Cells[Index].Origin }, FolderPath);
+    if (Spawned.Num() == 0)
+    {
+      continue;
+    }
+    AStaticMeshActor* Actor = Spawned[0];
+    if (ProxyMeshes[Index] != nullptr)
+    {
+      UStaticMeshComponent* MergedComponent = Actor->GetStaticMeshComponent();
+      MergedComponent->LDMaxDrawDistance = MergeSettings.ProxyDistance;
+      MergedComponent->CachedMaxDrawDistance = MergeSettings.ProxyDistance;
+
+      UStaticMeshComponent* ProxyComponent = AddStaticMeshComponentToActor(Actor);
+      ProxyComponent->SetStaticMesh(ProxyMeshes[Index]);
+      ProxyComponent->MinDrawDistance = MergeSettings.ProxyDistance;
+      ProxyComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+      MergedComponent->MarkRenderStateDirty();
+      ProxyComponent->MarkRenderStateDirty();
+    }
+    Result.Add(Actor);
+  }
+
+  if (MergeSettings.bRemoveSourceComponents)
+  {
+    for (const FMergeCell& Cell : Cells)
+    {
+      for (const FMergeSource& Source : Cell.Sources)
+      {
+        // An earlier source may have taken its actor with it.
+        if (!IsValid(Source.Component))
+        {
+          continue;
+        }
+        AActor* Owner = Source.Component->GetOwner();
+        if (Source.Component != Owner->GetRootComponent())
+        {
+          Source.Component->DestroyComponent();
+          continue;
+        }
+
+        TInlineComponentArray<UPrimitiveComponent*> Primitives(Owner);
+        if (Primitives.Num() == 1)
+        {
+          World->DestroyActor(Owner);
+        }
+        else
+        {
+          // Other components hang from it, so it stays but stops rendering
+          // and colliding.
+          Source.Component->SetStaticMesh(nullptr);
+        }
+      }
+    }
+  }
+
+  UE_LOG(LogCarlaMapGenFunctionLibrary, Log, TEXT("Merged %d components of %s into %d cells"),
+    Algo::TransformAccumulate(Cells, [](const FMergeCell& Cell) { return Cell.Sources.Num(); }, 0),
+    *MeshName.ToString(), Cells.Num());
+  return Result;
 }
 
 // Transverse Mercator projection, see e.g. https://proj.org/en/stable/operations/projections/tmerc.html
@@ -376,6 +1971,25 @@ USceneComponent* UMapGenFunctionLibrary::AddSceneComponentToActor(AActor* Target
     return SceneComp;
 }
 
+TArray<bool> UMapGenFunctionLibrary::ArePointsInsidePolygon(
+  const TArray<FVector>& Polygon,
+  const TArray<FVector>& Points)
+{
+  TArray<FVector2f> PolygonXY;
+  PolygonXY.Reserve(Polygon.Num());
+  for (const FVector& Vertex : Polygon)
+    PolygonXY.Emplace(Vertex.X, Vertex.Y);
+
+  TArray<FVector2f> PointsXY;
+  PointsXY.Reserve(Points.Num());
+  for (const FVector& Point : Points)
+    PointsXY.Emplace(Point.X, Point.Y);
+
+  TArray<bool> Inside;
+  Inside.SetNumZeroed(Points.Num());
+  FPolygonIndex2D(PolygonXY).ClassifyPoints(PointsXY, Inside);
+  return Inside;
+}
 
 void UMapGenFunctionLibrary::SmoothVerticesDeep(
   TArray<FVector>& Vertices,
@@ -385,75 +1999,45 @@ void UMapGenFunctionLibrary::SmoothVerticesDeep(
   float SmoothingFactor   // Blend between original and averaged
 )
 {
-  const int32 NumVertices = Vertices.Num();
+  TRACE_CPUPROFILER_EVENT_SCOPE(UMapGenFunctionLibrary::SmoothVerticesDeep);
 
-  // Step 1: Build adjacency map
-  TMap<int32, TSet<int32>> VertexNeighbors;
-  const int32 NumTriangles = Indices.Num() / 3;
-
-  for (int32 i = 0; i < NumTriangles; ++i)
+  if (Depth <= 0 || NumIterations <= 0)
   {
-      int32 I0 = Indices[i * 3 + 0];
-      int32 I1 = Indices[i * 3 + 1];
-      int32 I2 = Indices[i * 3 + 2];
-
-      VertexNeighbors.FindOrAdd(I0).Add(I1);
-      VertexNeighbors.FindOrAdd(I0).Add(I2);
-
-      VertexNeighbors.FindOrAdd(I1).Add(I0);
-      VertexNeighbors.FindOrAdd(I1).Add(I2);
-
-      VertexNeighbors.FindOrAdd(I2).Add(I0);
-      VertexNeighbors.FindOrAdd(I2).Add(I1);
+    return;
   }
 
-  // Step 2: Iterative smoothing
+  // Step 1: The neighbourhoods only depend on the triangles, so they are
+  // found once for all iterations
+  const FCompressedRows Rings = BuildVertexRings(BuildVertexAdjacency(Vertices.Num(), Indices), Depth);
+
+  // Step 2: Iterative smoothing, reading one buffer and writing the other
+  TArray<FVector> Buffer;
+  Buffer.SetNumUninitialized(Vertices.Num());
+  TArray<FVector>* Source = &Vertices;
+  TArray<FVector>* Target = &Buffer;
   for (int32 Iter = 0; Iter < NumIterations; ++Iter)
   {
-    TArray<FVector> NewVertices = Vertices;
-    for (int32 i = 0; i < NumVertices; ++i)
-    {
-        TSet<int32> Visited;
-        TQueue<TPair<int32, int32>> Queue; // Pair of (vertex index, current depth)
-        Visited.Add(i);
-        Queue.Enqueue(TPair<int32, int32>(i, 0));
-        TArray<int32> CollectedNeighbors;
-
-        while (!Queue.IsEmpty())
+    ParallelFor(Vertices.Num(), [&](int32 VertexIndex)
+      {
+        const TConstArrayView<int32> Ring = Rings.GetRow(VertexIndex);
+        if (Ring.Num() == 0)
         {
-          TPair<int32, int32> Current;
-          Queue.Dequeue(Current);
-          int32 CurrentIndex = Current.Key;
-          int32 CurrentDepth = Current.Value;
-
-          if (CurrentDepth >= Depth)
-              continue;
-          const TSet<int32>* Neighbors = VertexNeighbors.Find(CurrentIndex);
-          if (!Neighbors) continue;
-
-          for (int32 NeighborIndex : *Neighbors)
-          {
-            if (!Visited.Contains(NeighborIndex))
-            {
-              Visited.Add(NeighborIndex);
-              CollectedNeighbors.Add(NeighborIndex);
-              Queue.Enqueue(TPair<int32, int32>(NeighborIndex, CurrentDepth + 1));
-            }
-          }
+          (*Target)[VertexIndex] = (*Source)[VertexIndex];
+          return;
         }
-
-        if (CollectedNeighbors.Num() > 0)
+        FVector Average = FVector::ZeroVector;
+        for (int32 NeighborIdx : Ring)
         {
-          FVector Average = FVector::ZeroVector;
-          for (int32 NeighborIdx : CollectedNeighbors)
-          {
-            Average += Vertices[NeighborIdx];
-          }
-          Average /= CollectedNeighbors.Num();
-          NewVertices[i] = FMath::Lerp(Vertices[i], Average, SmoothingFactor);
+          Average += (*Source)[NeighborIdx];
         }
-    }
-    Vertices = NewVertices;
+        Average /= Ring.Num();
+        (*Target)[VertexIndex] = FMath::Lerp((*Source)[VertexIndex], Average, SmoothingFactor);
+      });
+    Swap(Source, Target);
+  }
+  if (Source != &Vertices)
+  {
+    Vertices = MoveTemp(Buffer);
   }
 }
 
@@ -0,0 +1,257 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/PoissonDiscCache.h"
+
+#include "Algo/Sort.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#include "CarlaMeshGeneration.h"
+
+namespace
+{
+  constexpr uint32 CacheMagic = 0x43445350; // "PSDC"
+  constexpr uint32 CacheFormatVersion = 1;
+
+  struct FCacheHeader
+  {
+    uint32 Magic;
+    uint32 Version;
+    uint64 Key;
+    uint32 Count;
+    uint32 Padding;
+  };
+
+  TAutoConsoleVariable<int32> CVarPoissonCacheMaxSizeMB(
+    TEXT("CarlaMeshGeneration.PoissonCache.MaxSizeMB"),
+    1024,
+    TEXT("Size budget of the on-disk Poisson disc sampling cache, in megabytes. ")
+    TEXT("The least recently used entries are deleted to stay under it. 0 disables the limit."));
+
+  TAutoConsoleVariable<int32> CVarPoissonIncrementalMaxSizeMB(
+    TEXT("CarlaMeshGeneration.PoissonIncremental.MaxSizeMB"),
+    256,
+    TEXT("Memory kept for incremental Poisson disc resampling, in megabytes. ")
+    TEXT("The least recently used splines are forgotten to stay under it."));
+
+  FAutoConsoleCommand PoissonCacheClearCommand(
+    TEXT("CarlaMeshGeneration.PoissonCache.Clear"),
+    TEXT("Deletes every entry of the on-disk Poisson disc sampling cache."),
+    FConsoleCommandDelegate::CreateLambda([]() { FPoissonDiscCache::Get().Clear(); }));
+
+  struct FCacheFile
+  {
+    FString Path;
+    FDateTime LastUsed;
+    int64 Size;
+  };
+
+  /**
+   * Lists the entries in Directory. Temporary files of stores in progress are
+   * left out, they are renamed to entries or deleted shortly.
+   */
+  TArray<FCacheFile> ListCacheFiles(const FString& Directory)
+  {
+    TArray<FCacheFile> Files;
+    IFileManager::Get().IterateDirectoryStat(*Directory,
+      [&Files](const TCHAR* Path, const FFileStatData& Stat)
+      {
+        const FString Filename = FPaths::GetCleanFilename(Path);
+        if (!Stat.bIsDirectory && Filename.EndsWith(TEXT(".bin")) && !Filename.StartsWith(TEXT("tmp_")))
+          Files.Add({ Path, Stat.ModificationTime, Stat.FileSize });
+        return true;
+      });
+    return Files;
+  }
+}
+
+FPoissonDiscCache& FPoissonDiscCache::Get()
+{
+  static FPoissonDiscCache Instance;
+  return Instance;
+}
+
+FString FPoissonDiscCache::GetCacheDirectory() const
+{
+  return FPaths::ProjectSavedDir() / TEXT("CarlaMeshGeneration") / TEXT("PoissonCache");
+}
+
+FString FPoissonDiscCache::GetEntryPath(uint64 Key) const
+{
+  return GetCacheDirectory() / FString::Printf(TEXT("%016llx.bin"), Key);
+}
+
+bool FPoissonDiscCache::Load(uint64 Key, TArray<FVector2f>& OutPoints) const
+{
+  TArray<uint8> Bytes;
+  if (!FFileHelper::LoadFileToArray(Bytes, *GetEntryPath(Key), FILEREAD_Silent))
+    return false;
+
+  if (Bytes.Num() < (int64)sizeof(FCacheHeader))
+    return false;
+
+  FCacheHeader Header;
+  FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+  const int64 PayloadSize = (int64)Header.Count * sizeof(FVector2f);
+  if (Header.Magic != CacheMagic ||
+      Header.Version != CacheFormatVersion ||
+      Header.Key != Key ||
+      Bytes.Num() != (int64)sizeof(FCacheHeader) + PayloadSize)
+  {
+    UE_LOG(LogCarlaMeshGeneration, Warning, TEXT("Discarding invalid Poisson cache entry %016llx"), Key);
+    return false;
+  }
+
+  OutPoints.SetNumUninitialized(Header.Count);
+  FMemory::Memcpy(OutPoints.GetData(), Bytes.GetData() + sizeof(FCacheHeader), PayloadSize);
+
+  // The modification time doubles as the last use, so hits are the last to
+  // be evicted.
+  IFileManager::Get().SetTimeStamp(*GetEntryPath(Key), FDateTime::UtcNow());
+  return true;
+}
+
+void FPoissonDiscCache::Store(uint64 Key, TConstArrayView<FVector2f> Points)
+{
+  FCacheHeader Header = {};
+  Header.Magic = CacheMagic;
+  Header.Version = CacheFormatVersion;
+  Header.Key = Key;
+  Header.Count = (uint32)Points.Num();
+
+  const int64 PayloadSize = (int64)Points.Num() * sizeof(FVector2f);
+  TArray<uint8> Bytes;
+  Bytes.SetNumUninitialized(sizeof(FCacheHeader) + PayloadSize);
+  FMemory::Memcpy(Bytes.GetData(), &Header, sizeof(Header));
+  FMemory::Memcpy(Bytes.GetData() + sizeof(FCacheHeader), Points.GetData(), PayloadSize);
+
+  // Write to a unique temporary file first so concurrent readers never see a
+  // partially written entry.
+  const FString EntryPath = GetEntryPath(Key);
+  const FString TempPath = FPaths::CreateTempFilename(*GetCacheDirectory(), TEXT("tmp_"), TEXT(".bin"));
+  IFileManager& FileManager = IFileManager::Get();
+  if (!FFileHelper::SaveArrayToFile(Bytes, *TempPath))
+  {
+    UE_LOG(LogCarlaMeshGeneration, Warning, TEXT("Could not write Poisson cache entry %s"), *TempPath);
+    return;
+  }
+  if (!FileManager.Move(*EntryPath, *TempPath, true, true))
+  {
+    FileManager.Delete(*TempPath, false, false, true);
+    return;
+  }
+
+  const int64 MaxBytes = (int64)CVarPoissonCacheMaxSizeMB.GetValueOnAnyThread() * 1024 * 1024;
+  FScopeLock ScopeLock(&Lock);
+  if (TotalBytes < 0)
+  {
+    TotalBytes = 0;
+    for (const FCacheFile& File : ListCacheFiles(GetCacheDirectory()))
+      TotalBytes += File.Size;
+  }
+  else
+  {
+    TotalBytes += Bytes.Num();
+  }
+
+  // Trimming below the budget leaves room for many stores before the next
+  // listing of the directory.
+  if (MaxBytes > 0 && TotalBytes > MaxBytes)
+    Trim(MaxBytes * 3 / 4);
+}
+
+void FPoissonDiscCache::Clear()
+{
+  FScopeLock ScopeLock(&Lock);
+  Trim(0);
+  UE_LOG(LogCarlaMeshGeneration, Log, TEXT("Cleared the Poisson cache in %s"), *GetCacheDirectory());
+}
+
+void FPoissonDiscCache::Trim(int64 TargetBytes)
+{
+  TArray<FCacheFile> Files = ListCacheFiles(GetCacheDirectory());
+  Algo::SortBy(Files, &FCacheFile::LastUsed);
+
+  TotalBytes = 0;
+  for (const FCacheFile& File : Files)
+    TotalBytes += File.Size;
+
+  int32 NumDeleted = 0;
+  for (const FCacheFile& File : Files)
+  {
+    if (TotalBytes <= TargetBytes)
+      break;
+    if (IFileManager::Get().Delete(*File.Path, false, false, true))
+    {
+      TotalBytes -= File.Size;
+      ++NumDeleted;
+    }
+  }
+  UE_LOG(LogCarlaMeshGeneration, Verbose, TEXT("Evicted %d Poisson cache entries, %lld bytes remain"), NumDeleted, TotalBytes);
+}
+
+FPoissonIncrementalStore& FPoissonIncrementalStore::Get()
+{
+  static FPoissonIncrementalStore Instance;
+  return Instance;
+}
+
+TSharedPtr<const FPoissonIncrementalStore::FEntry> FPoissonIncrementalStore::Find(const FKey& Key)
+{
+  FScopeLock ScopeLock(&Lock);
+  FSlot* Slot = Entries.Find(Key);
+  if (Slot == nullptr)
+    return nullptr;
+  Slot->LastUse = ++UseCount;
+  return Slot->Entry;
+}
+
+void FPoissonIncrementalStore::Store(const FKey& Key, TSharedRef<const FEntry> Entry)
+{
+  const SIZE_T Size = Entry->SplineVertices.GetAllocatedSize() + Entry->Points.GetAllocatedSize();
+  const SIZE_T MaxSize = (SIZE_T)FMath::Max(CVarPoissonIncrementalMaxSizeMB.GetValueOnAnyThread(), 0) * 1024 * 1024;
+
+  FScopeLock ScopeLock(&Lock);
+  if (const FSlot* Previous = Entries.Find(Key))
+    TotalSize -= Previous->Size;
+  Entries.Add(Key, FSlot{ MoveTemp(Entry), Size, ++UseCount });
+  TotalSize += Size;
+  if (TotalSize <= MaxSize)
+    return;
+
+  // The entry just stored is the most recently used, so it is only evicted
+  // if it is over the budget on its own.
+  TArray<TPair<uint64, FKey>> ByLastUse;
+  ByLastUse.Reserve(Entries.Num());
+  for (const TPair<FKey, FSlot>& Pair : Entries)
+    ByLastUse.Emplace(Pair.Value.LastUse, Pair.Key);
+  ByLastUse.Sort([](const TPair<uint64, FKey>& A, const TPair<uint64, FKey>& B) { return A.Key < B.Key; });
+  for (const TPair<uint64, FKey>& Pair : ByLastUse)
+  {
+    if (TotalSize <= MaxSize)
+      break;
+    TotalSize -= Entries.FindChecked(Pair.Value).Size;
+    Entries.Remove(Pair.Value);
+  }
+}
+
+void FPoissonIncrementalStore::RemoveStale()
+{
+  check(IsInGameThread());
+  FScopeLock ScopeLock(&Lock);
+  for (auto It = Entries.CreateIterator(); It; ++It)
+  {
+    if (It.Key().Owner.ResolveObjectPtr() == nullptr)
+    {
+      TotalSize -= It.Value().Size;
+      It.RemoveCurrent();
+    }
+  }
+}
@@ -0,0 +1,671 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/PoissonDiscSampler.h"
+#include "Generation/SpatialIndex2D.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/VectorRegister.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include "CarlaMeshGeneration.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using RealT = float;
+using IntT = int32;
+using V2 = UE::Math::TVector2<RealT>;
+using I2 = FIntPoint;
+using Edge = std::pair<V2, V2>;
+
+// With cells of size R / sqrt(2), any point closer than R to a candidate lies
+// in the 5x5 block of cells around it.
+static constexpr IntT NeighborhoodRadius = 2;
+static constexpr IntT NeighborhoodWidth = 2 * NeighborhoodRadius + 1;
+
+// Coordinate stored in empty cells. It is far enough from any real point that
+// the distance test never matches it, so empty cells need no branch.
+static constexpr RealT EmptyCellCoord = TNumericLimits<RealT>::Max();
+
+// Candidates drawn at once around an active point. A multiple of the vector
+// width, since their directions are computed four at a time.
+static constexpr IntT CandidateBatchSize = 8;
+
+// Returns true if any point in the 5x5 block of cells centred on Center is
+// closer than sqrt(R2) to Point. Rows of the block are RowStride cells apart
+// and every cell of a row is read, so the block must be fully addressable.
+// Each vector holds two interleaved cells; the last one of a row overlaps the
+// middle one instead of reading past the block.
+static bool IsAnyWithinDistance(V2 Point, const V2* Center, std::ptrdiff_t RowStride, RealT R2)
+{
+  const VectorRegister4Float PointXY = VectorSet(Point.X, Point.Y, Point.X, Point.Y);
+  const VectorRegister4Float Radius2 = VectorSetFloat1(R2);
+  VectorRegister4Float AnyClose = VectorZeroFloat();
+
+  auto TestPair = [&](const V2* Cells)
+    {
+      const VectorRegister4Float Delta = VectorSubtract(VectorLoad(&Cells->X), PointXY);
+      const VectorRegister4Float Squared = VectorMultiply(Delta, Delta);
+      const VectorRegister4Float Dist2 = VectorAdd(Squared, VectorSwizzle(Squared, 1, 0, 3, 2));
+      AnyClose = VectorBitwiseOr(AnyClose, VectorCompareLT(Dist2, Radius2));
+    };
+
+  for (IntT Y = -NeighborhoodRadius; Y <= NeighborhoodRadius; ++Y)
+  {
+    const V2* Row = Center + Y * RowStride;
+    TestPair(Row - 2);
+    TestPair(Row);
+    TestPair(Row + 1);
+  }
+  return VectorMaskBits(AnyClose) != 0;
+}
+
+// Slow path for cells near the edge of the grid or of a page: copies the
+// neighbourhood into a local block, with empty cells outside the grid.
+template <typename GridT>
+static bool IsAnyWithinDistanceClamped(const GridT& Grid, I2 Size, I2 Key, V2 Point, RealT R2)
+{
+  V2 Block[NeighborhoodWidth * NeighborhoodWidth];
+  for (IntT Y = 0; Y < NeighborhoodWidth; ++Y)
+  {
+    for (IntT X = 0; X < NeighborhoodWidth; ++X)
+    {
+      const I2 Test(Key.X + X - NeighborhoodRadius, Key.Y + Y - NeighborhoodRadius);
+      const bool bInBounds = Test.X >= 0 && Test.Y >= 0 && Test.X < Size.X && Test.Y < Size.Y;
+      Block[X + Y * NeighborhoodWidth] = bInBounds ? Grid.Get(Test) : V2(EmptyCellCoord, EmptyCellCoord);
+    }
+  }
+  const IntT CenterIndex = NeighborhoodRadius * (NeighborhoodWidth + 1);
+  return IsAnyWithinDistance(Point, Block + CenterIndex, NeighborhoodWidth, R2);
+}
+
+// Background grid storing, for every cell, the accepted point it contains, or
+// EmptyCellCoord in both coordinates. Keeping the points themselves in the
+// grid lets the neighbourhood test read them without any indirection. The
+// dense variant is a flat array over the whole bounding box.
+class FDensePoissonGrid
+{
+public:
+
+  explicit FDensePoissonGrid(I2 InSize) :
+    Size(InSize),
+    Cells((std::size_t)InSize.X * (std::size_t)InSize.Y, V2(EmptyCellCoord, EmptyCellCoord))
+  {
+  }
+
+  V2 Get(I2 Key) const
+  {
+    return Cells[FlatIndex(Key)];
+  }
+
+  void Set(I2 Key, V2 Point)
+  {
+    Cells[FlatIndex(Key)] = Point;
+  }
+
+  bool IsAnyWithinDistance(I2 Key, V2 Point, RealT R2) const
+  {
+    if (Key.X < NeighborhoodRadius || Key.X >= Size.X - NeighborhoodRadius ||
+      Key.Y < NeighborhoodRadius || Key.Y >= Size.Y - NeighborhoodRadius)
+      return IsAnyWithinDistanceClamped(*this, Size, Key, Point, R2);
+    return ::IsAnyWithinDistance(Point, Cells.data() + FlatIndex(Key), Size.X, R2);
+  }
+
+private:
+
+  std::size_t FlatIndex(I2 Key) const
+  {
+    return (std::size_t)Key.X + (std::size_t)Key.Y * (std::size_t)Size.X;
+  }
+
+  I2 Size;
+  std::vector<V2> Cells;
+};
+
+// Fallback for bounding boxes too large to allocate densely. The grid is split
+// into square pages of cells that are only allocated once a point lands in
+// them, so memory follows the sampled area instead of the bounding box.
+class FTiledPoissonGrid
+{
+public:
+
+  static constexpr IntT PageShift = 6;
+  static constexpr IntT PageSize = 1 << PageShift;
+  static constexpr IntT PageMask = PageSize - 1;
+  static constexpr IntT CellsPerPage = PageSize * PageSize;
+
+  explicit FTiledPoissonGrid(I2 InSize) :
+    Size(InSize),
+    PageCount((InSize.X + PageMask) >> PageShift, (InSize.Y + PageMask) >> PageShift),
+    Pages((std::size_t)PageCount.X * (std::size_t)PageCount.Y)
+  {
+  }
+
+  V2 Get(I2 Key) const
+  {
+    const V2* Page = Pages[PageIndex(Key)].get();
+    return Page != nullptr ? Page[CellIndex(Key)] : V2(EmptyCellCoord, EmptyCellCoord);
+  }
+
+  void Set(I2 Key, V2 Point)
+  {
+    std::unique_ptr<V2[]>& Page = Pages[PageIndex(Key)];
+    if (!Page)
+    {
+      Page = std::make_unique<V2[]>(CellsPerPage);
+      std::fill_n(Page.get(), CellsPerPage, V2(EmptyCellCoord, EmptyCellCoord));
+    }
+    Page[CellIndex(Key)] = Point;
+  }
+
+  bool IsAnyWithinDistance(I2 Key, V2 Point, RealT R2) const
+  {
+    const I2 Local(Key.X & PageMask, Key.Y & PageMask);
+    if (Local.X < NeighborhoodRadius || Local.X >= PageSize - NeighborhoodRadius ||
+      Local.Y < NeighborhoodRadius || Local.Y >= PageSize - NeighborhoodRadius)
+      return IsAnyWithinDistanceClamped(*this, Size, Key, Point, R2);
+
+    // The whole neighbourhood lies in one page. Cells of the page beyond the
+    // grid are never set, so they need no bounds check.
+    const V2* Page = Pages[PageIndex(Key)].get();
+    return Page != nullptr && ::IsAnyWithinDistance(Point, Page + CellIndex(Key), PageSize, R2);
+  }
+
+private:
+
+  std::size_t PageIndex(I2 Key) const
+  {
+    return (std::size_t)(Key.X >> PageShift) + (std::size_t)(Key.Y >> PageShift) * (std::size_t)PageCount.X;
+  }
+
+  static IntT CellIndex(I2 Key)
+  {
+    return (Key.X & PageMask) + ((Key.Y & PageMask) << PageShift);
+  }
+
+  I2 Size;
+  I2 PageCount;
+  std::vector<std::unique_ptr<V2[]>> Pages;
+};
+
+// Classification of the Poisson grid cells against the spline polygon, using
+// the same nonzero winding rule as FPolygonIndex2D. The mask is stored per
+// sampling tile: tiles entirely inside or outside the polygon keep a single
+// class and only tiles crossed by the boundary store one byte per cell.
+class FPoissonCellMask
+{
+public:
+
+  enum ECellClass : uint8
+  {
+    Outside,
+    Inside,
+    Boundary
+  };
+
+  FPoissonCellMask(I2 InTileCount, IntT InTileShift) :
+    TileCount(InTileCount),
+    TileShift(InTileShift),
+    TileClasses((std::size_t)InTileCount.X * (std::size_t)InTileCount.Y, Inside),
+    TileCells((std::size_t)InTileCount.X * (std::size_t)InTileCount.Y)
+  {
+  }
+
+  // Returns Boundary for tiles that store per-cell classes.
+  ECellClass GetTileClass(IntT TileIndex) const
+  {
+    return TileClasses[TileIndex];
+  }
+
+  ECellClass Get(I2 Cell) const
+  {
+    const IntT TileIndex = (Cell.X >> TileShift) + (Cell.Y >> TileShift) * TileCount.X;
+    const uint8* Cells = TileCells[TileIndex].get();
+    if (Cells == nullptr)
+      return TileClasses[TileIndex];
+    const IntT LocalMask = (1 << TileShift) - 1;
+    return (ECellClass)Cells[(Cell.X & LocalMask) + ((Cell.Y & LocalMask) << TileShift)];
+  }
+
+  // Classifies every cell by the winding number at its centre, then marks the
+  // cells any edge passes through as Boundary. Rows of tiles are independent
+  // and are rasterized in parallel.
+  void Rasterize(
+    const FPolygonIndex2D& Polygon,
+    V2 Min,
+    RealT CellSize,
+    I2 GridSize,
+    EParallelForFlags Flags)
+  {
+    const IntT TileSize = 1 << TileShift;
+    const RealT Epsilon = CellSize * (RealT)1e-3;
+
+    ParallelFor(TileCount.Y, [&](int32 TileY)
+      {
+        const IntT Row0 = TileY << TileShift;
+        const IntT NumRows = FMath::Min(TileSize, GridSize.Y - Row0);
+        const RealT BandMinY = Min.Y + (RealT)Row0 * CellSize;
+        const RealT BandMaxY = Min.Y + (RealT)(Row0 + NumRows) * CellSize;
+
+        TConstArrayView<FVector2f> Vertices = Polygon.GetVertices();
+        std::vector<Edge> BandEdges;
+        for (int32 i = 0; i < Vertices.Num(); ++i)
+        {
+          const Edge E(Vertices[i], Vertices[(i + 1) % Vertices.Num()]);
+          if (FMath::Max(E.first.Y, E.second.Y) >= BandMinY &&
+            FMath::Min(E.first.Y, E.second.Y) <= BandMaxY)
+            BandEdges.push_back(E);
+        }
+
+        std::vector<uint8> Band((std::size_t)NumRows * (std::size_t)GridSize.X, Outside);
+        TArray<TPair<float, int32>> Crossings;
+
+        auto ToColumn = [&](RealT X)
+          {
+            return FMath::Clamp(FMath::FloorToInt((X - Min.X) / CellSize), 0, GridSize.X - 1);
+          };
+
+        // First column whose cell centre is at or right of X.
+        auto ToCenterColumn = [&](RealT X)
+          {
+            return FMath::FloorToInt((X - Min.X) / CellSize - (RealT)0.5) + 1;
+          };
+
+        for (IntT Row = 0; Row < NumRows; ++Row)
+        {
+          uint8* Cells = Band.data() + (std::size_t)Row * (std::size_t)GridSize.X;
+          const RealT RowMinY = Min.Y + (RealT)(Row0 + Row) * CellSize;
+          const RealT RowMaxY = RowMinY + CellSize;
+          const RealT CenterY = RowMinY + (RealT)0.5 * CellSize;
+
+          // Winding number along the row through the cell centres.
+          Crossings.Reset();
+          Polygon.GetCrossings(CenterY, Crossings);
+          Crossings.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+            {
+              return A.Key < B.Key;
+            });
+
+          IntT Winding = 0;
+          for (int32 i = 0; i + 1 < Crossings.Num(); ++i)
+          {
+            Winding += Crossings[i].Value;
+            if (Winding == 0)
+              continue;
+            // Cells whose centre lies in [Crossings[i], Crossings[i + 1]).
+            const IntT First = ToCenterColumn(Crossings[i].Key);
+            const IntT Last = ToCenterColumn(Crossings[i + 1].Key);
+            for (IntT X = FMath::Max(First, 0); X < FMath::Min(Last, GridSize.X); ++X)
+              Cells[X] = Inside;
+          }
+
+          // Every cell an edge passes through needs an exact test.
+          for (const Edge& E : BandEdges)
+          {
+            const V2 A = E.first;
+            const V2 B = E.second;
+            const RealT DY = B.Y - A.Y;
+            RealT T0 = 0, T1 = 1;
+            if (DY != 0)
+            {
+              T0 = (RowMinY - A.Y) / DY;
+              T1 = (RowMaxY - A.Y) / DY;
+              if (T0 > T1)
+                std::swap(T0, T1);
+              T0 = FMath::Max(T0, (RealT)0);
+              T1 = FMath::Min(T1, (RealT)1);
+              if (T0 > T1)
+                continue;
+            }
+            else if (A.Y < RowMinY || A.Y > RowMaxY)
+            {
+              continue;
+            }
+            const RealT X0 = A.X + (B.X - A.X) * T0;
+            const RealT X1 = A.X + (B.X - A.X) * T1;
+            const IntT First = ToColumn(FMath::Min(X0, X1) - Epsilon);
+            const IntT Last = ToColumn(FMath::Max(X0, X1) + Epsilon);
+            for (IntT X = First; X <= Last; ++X)
+              Cells[X] = Boundary;
+          }
+        }
+
+        // Collapse tiles that ended up uniform into a single class.
+        for (IntT TileX = 0; TileX < TileCount.X; ++TileX)
+        {
+          const IntT Col0 = TileX << TileShift;
+          const IntT NumCols = FMath::Min(TileSize, GridSize.X - Col0);
+          const uint8 FirstClass = Band[Col0];
+          bool bUniform = true;
+          for (IntT Row = 0; Row < NumRows && bUniform; ++Row)
+          {
+            const uint8* Cells = Band.data() + (std::size_t)Row * (std::size_t)GridSize.X + Col0;
+            bUniform = std::all_of(Cells, Cells + NumCols, [&](uint8 C) { return C == FirstClass; });
+          }
+
+          const IntT TileIndex = TileX + TileY * TileCount.X;
+          if (bUniform && FirstClass != Boundary)
+          {
+            TileClasses[TileIndex] = (ECellClass)FirstClass;
+            continue;
+          }
+
+          TileClasses[TileIndex] = Boundary;
+          std::unique_ptr<uint8[]>& TileMask = TileCells[TileIndex];
+          TileMask = std::make_unique<uint8[]>((std::size_t)TileSize * TileSize);
+          std::fill_n(TileMask.get(), TileSize * TileSize, (uint8)Outside);
+          for (IntT Row = 0; Row < NumRows; ++Row)
+          {
+            std::copy_n(
+              Band.data() + (std::size_t)Row * (std::size_t)GridSize.X + Col0,
+              NumCols,
+              TileMask.get() + Row * TileSize);
+          }
+        }
+      }, Flags);
+  }
+
+private:
+
+  I2 TileCount;
+  IntT TileShift;
+  std::vector<ECellClass> TileClasses;
+  std::vector<std::unique_ptr<uint8[]>> TileCells;
+};
+
+TArray<FVector2f> FPoissonDiscSampler::Generate(const FPoissonDiscSamplerParams& Params)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(FPoissonDiscSampler::Generate);
+  const double StartTime = FPlatformTime::Seconds();
+
+  const RealT Sqrt2 = FMath::Sqrt((RealT)2);
+
+  const RealT R = (RealT)Params.MinDistance;
+  const RealT R2 = R * R;
+
+  // New points are placed inside SampleMin..SampleMax. Fixed points up to one
+  // minimum distance outside still constrain them, so when there are any the
+  // grid reaches that far too.
+  const V2 SampleMin = Params.Bounds.Min;
+  const V2 SampleMax = Params.Bounds.Max;
+  const V2 Margin = Params.FixedPoints.IsEmpty() ? V2(0, 0) : V2(R, R);
+  const V2 Min = SampleMin - Margin;
+  const V2 Max = SampleMax + Margin;
+  const V2 Extent = Max - Min;
+  const IntT MaxRetries = Params.MaxRetries;
+  const uint64 Seed = Params.Seed;
+
+  auto IsCancelled = [&]()
+    {
+      return Params.bCancelled != nullptr && Params.bCancelled->load(std::memory_order_relaxed);
+    };
+
+  const RealT CellSize = R / Sqrt2;
+  const V2 GridFloat = Extent / CellSize;
+  const FIntPoint GridSize(FMath::CeilToInt(GridFloat.X), FMath::CeilToInt(GridFloat.Y));
+  if (GridSize.X <= 0 || GridSize.Y <= 0)
+    return {};
+
+  const int64 CellCount = (int64)GridSize.X * (int64)GridSize.Y;
+  const int64 DenseGridBytes = CellCount * (int64)sizeof(V2);
+  const int64 GridBudgetBytes = (int64)FMath::Max(Params.GridMemoryBudgetMB, 0) << 20;
+  const bool bUseDenseGrid = DenseGridBytes <= GridBudgetBytes;
+
+  // The grid is split into square tiles of cells that are sampled
+  // independently. Tiles run in the four phases of a 2x2 colouring, so tiles
+  // sampled at the same time are a whole tile apart and never touch each
+  // other's cells, while the 5x5 neighbourhood test still sees every point
+  // accepted across the border in an earlier phase. Each tile draws from its
+  // own random stream, so the result does not depend on the thread count.
+  // Tiles of the sparse grid must coincide with its pages, since a page is
+  // allocated by the tile writing into it. The dense grid uses the same tiles
+  // so the points do not depend on GridMemoryBudgetMB, which is not part of
+  // the cache keys.
+  const IntT TileShift = FTiledPoissonGrid::PageShift;
+  const IntT TileSize = 1 << TileShift;
+  const I2 TileCount(
+    (GridSize.X + TileSize - 1) >> TileShift,
+    (GridSize.Y + TileSize - 1) >> TileShift);
+  const int64 NumTiles = (int64)TileCount.X * (int64)TileCount.Y;
+  if (NumTiles > (int64)MAX_int32)
+  {
+    UE_LOG(LogCarlaMeshGeneration, Error, TEXT("Poisson sampling area is too large (%lld cells)."), CellCount);
+    return {};
+  }
+
+  std::vector<std::vector<V2>> TilePoints(NumTiles);
+
+  const EParallelForFlags Flags = Params.bParallel ?
+    EParallelForFlags::None :
+    EParallelForFlags::ForceSingleThread;
+
+  // Only cells inside the polygon are sampled, so the cost follows its area
+  // rather than its bounding box.
+  FPoissonCellMask Mask(TileCount, TileShift);
+  if (Params.Polygon != nullptr && !Params.Polygon->IsEmpty())
+    Mask.Rasterize(*Params.Polygon, Min, CellSize, GridSize, Flags);
+
+  auto GetGridCoord = [&](V2 Point)
+    {
+      V2 Tmp = (Point - Min) / CellSize;
+      return I2((IntT)Tmp.X, (IntT)Tmp.Y);
+    };
+
+  auto SampleTile = [&](auto& Grid, IntT TileIndex)
+    {
+      const I2 Tile(TileIndex % TileCount.X, TileIndex / TileCount.X);
+      const I2 CellMin(Tile.X << TileShift, Tile.Y << TileShift);
+      const I2 CellMax(
+        FMath::Min(CellMin.X + TileSize, GridSize.X),
+        FMath::Min(CellMin.Y + TileSize, GridSize.Y));
+      const V2 TileMin = V2::Max(Min + V2((RealT)CellMin.X, (RealT)CellMin.Y) * CellSize, SampleMin);
+      const V2 TileMax = V2::Min(Min + V2((RealT)CellMax.X, (RealT)CellMax.Y) * CellSize, SampleMax);
+
+      const FPoissonCellMask::ECellClass TileClass = Mask.GetTileClass(TileIndex);
+      if (TileClass == FPoissonCellMask::Outside || IsCancelled())
+        return;
+
+      FPoissonRandom PRNG(FPoissonRandom::Mix(Seed + (uint64)TileIndex));
+      std::vector<V2>& Results2D = TilePoints[TileIndex];
+      std::vector<V2> Pending;
+
+      // Scratch space for the candidate kernel, reused for every candidate.
+      alignas(16) RealT CandidateAngle[CandidateBatchSize];
+      alignas(16) RealT CandidateSin[CandidateBatchSize];
+      alignas(16) RealT CandidateCos[CandidateBatchSize];
+      RealT CandidateRadius[CandidateBatchSize];
+
+      auto GetRandomScalar = [&](RealT MinVal, RealT MaxVal)
+        {
+          return std::fma(PRNG.NextUnit(), MaxVal - MinVal, MinVal);
+        };
+
+      auto GetRandomPoint = [&](V2 A, V2 B)
+        {
+          return V2(
+            GetRandomScalar(A.X, B.X),
+            GetRandomScalar(A.Y, B.Y));
+        };
+
+      auto TryAdd = [&](V2 NewPoint)
+        {
+          if (NewPoint.X < SampleMin.X || NewPoint.X >= SampleMax.X ||
+            NewPoint.Y < SampleMin.Y || NewPoint.Y >= SampleMax.Y)
+            return false;
+
+          I2 GridCoord = GetGridCoord(NewPoint);
+          if (GridCoord.X < CellMin.X || GridCoord.X >= CellMax.X ||
+            GridCoord.Y < CellMin.Y || GridCoord.Y >= CellMax.Y)
+            return false;
+
+          const FPoissonCellMask::ECellClass CellClass = Mask.Get(GridCoord);
+          if (CellClass == FPoissonCellMask::Outside)
+            return false;
+
+          if (Grid.IsAnyWithinDistance(GridCoord, NewPoint, R2))
+            return false;
+
+          if (CellClass == FPoissonCellMask::Boundary && !Params.Polygon->IsInside(NewPoint))
+            return false;
+
+          Grid.Set(GridCoord, NewPoint);
+          Results2D.push_back(NewPoint);
+          Pending.push_back(NewPoint);
+          return true;
+        };
+
+      // Darts are only thrown into cells that are not entirely outside.
+      std::vector<I2> DartCells;
+      if (TileClass == FPoissonCellMask::Boundary)
+      {
+        for (IntT Y = CellMin.Y; Y < CellMax.Y; ++Y)
+          for (IntT X = CellMin.X; X < CellMax.X; ++X)
+            if (Mask.Get(I2(X, Y)) != FPoissonCellMask::Outside)
+              DartCells.emplace_back(X, Y);
+      }
+
+      auto GetRandomDart = [&]()
+        {
+          if (DartCells.empty())
+            return GetRandomPoint(TileMin, TileMax);
+          const I2 Cell = DartCells[PRNG.NextIndex((IntT)DartCells.size())];
+          const V2 CellMinPoint = Min + V2((RealT)Cell.X, (RealT)Cell.Y) * CellSize;
+          return GetRandomPoint(CellMinPoint, CellMinPoint + V2(CellSize, CellSize));
+        };
+
+      // Points accepted by neighbouring tiles in earlier phases keep growing
+      // into this tile, which avoids seams along the tile borders. Cells of
+      // the tile itself only hold fixed points at this stage, which grow the
+      // same way.
+      for (IntT Y = FMath::Max(CellMin.Y - 2, 0); Y < FMath::Min(CellMax.Y + 2, GridSize.Y); ++Y)
+      {
+        for (IntT X = FMath::Max(CellMin.X - 2, 0); X < FMath::Min(CellMax.X + 2, GridSize.X); ++X)
+        {
+          const V2 Neighbor = Grid.Get(I2(X, Y));
+          if (Neighbor.X != EmptyCellCoord)
+            Pending.push_back(Neighbor);
+        }
+      }
+
+      while (true)
+      {
+        while (!Pending.empty())
+        {
+          const IntT Index = PRNG.NextIndex((IntT)Pending.size());
+          const V2 Point = Pending[Index];
+          bool Found = false;
+
+          // Candidates are generated a batch at a time, so the random draws
+          // and trigonometry run back to back instead of interleaved with the
+          // grid lookups.
+          for (IntT Batch = 0; Batch < MaxRetries && !Found; Batch += CandidateBatchSize)
+          {
+            for (IntT i = 0; i < CandidateBatchSize; ++i)
+            {
+              CandidateAngle[i] = GetRandomScalar(-PI, PI);
+              CandidateRadius[i] = GetRandomScalar(R, 2 * R);
+            }
+
+            for (IntT i = 0; i < CandidateBatchSize; i += 4)
+            {
+              const VectorRegister4Float Angle = VectorLoadAligned(CandidateAngle + i);
+              VectorRegister4Float Sin, Cos;
+              VectorSinCos(&Sin, &Cos, &Angle);
+              VectorStoreAligned(Sin, CandidateSin + i);
+              VectorStoreAligned(Cos, CandidateCos + i);
+            }
+
+            const IntT BatchSize = FMath::Min(CandidateBatchSize, MaxRetries - Batch);
+            for (IntT i = 0; i < BatchSize && !Found; ++i)
+            {
+              const V2 Direction(CandidateCos[i], CandidateSin[i]);
+              Found = TryAdd(Point + CandidateRadius[i] * Direction);
+            }
+          }
+
+          // The active list is unordered, so exhausted points are removed by
+          // swapping in the last one.
+          if (!Found)
+          {
+            Pending[Index] = Pending.back();
+            Pending.pop_back();
+          }
+        }
+
+        // Start a new front in any part of the tile the previous ones did not
+        // reach; the tile is done once MaxRetries darts in a row fail.
+        bool bSeeded = false;
+        for (IntT i = 0; i < MaxRetries && !bSeeded; ++i)
+          bSeeded = TryAdd(GetRandomDart());
+        if (!bSeeded)
+          break;
+      }
+    };
+
+  auto Run = [&](auto& Grid)
+    {
+      // Rounding can put a point just short of Max into the cell past the
+      // last one, so its cell is checked against the grid too, as it is for
+      // darts. Points outside the grid are at least R from the sampled area.
+      for (const V2& Point : Params.FixedPoints)
+      {
+        if (Point.X < Min.X || Point.X >= Max.X || Point.Y < Min.Y || Point.Y >= Max.Y)
+          continue;
+
+        const I2 GridCoord = GetGridCoord(Point);
+        if (GridCoord.X < GridSize.X && GridCoord.Y < GridSize.Y)
+          Grid.Set(GridCoord, Point);
+      }
+
+      std::vector<IntT> PhaseTiles;
+      for (IntT Phase = 0; Phase < 4; ++Phase)
+      {
+        PhaseTiles.clear();
+        for (IntT Y = Phase >> 1; Y < TileCount.Y; Y += 2)
+          for (IntT X = Phase & 1; X < TileCount.X; X += 2)
+            PhaseTiles.push_back(X + Y * TileCount.X);
+
+        ParallelFor((int32)PhaseTiles.size(), [&](int32 i)
+          {
+            SampleTile(Grid, PhaseTiles[i]);
+          }, Flags);
+      }
+    };
+
+  if (bUseDenseGrid)
+  {
+    FDensePoissonGrid Grid(GridSize);
+    Run(Grid);
+  }
+  else
+  {
+    UE_LOG(LogCarlaMeshGeneration, Verbose,
+      TEXT("Poisson grid of %lld cells exceeds the %d MB budget, using tiled storage."),
+      CellCount, Params.GridMemoryBudgetMB);
+    FTiledPoissonGrid Grid(GridSize);
+    Run(Grid);
+  }
+
+  if (IsCancelled())
+    return {};
+
+  std::size_t Total = 0;
+  for (const std::vector<V2>& Points : TilePoints)
+    Total += Points.size();
+
+  TArray<FVector2f> Results2D;
+  Results2D.Reserve((int32)Total);
+  for (const std::vector<V2>& Points : TilePoints)
+    Results2D.Append(Points.data(), (int32)Points.size());
+
+  const double Elapsed = FPlatformTime::Seconds() - StartTime;
+  UE_LOG(LogCarlaMeshGeneration, Verbose, TEXT("Poisson sampling generated %d points in %.3f s (%.0f points/s)."),
+    Results2D.Num(), Elapsed, Elapsed > 0.0 ? (double)Results2D.Num() / Elapsed : 0.0);
+  return Results2D;
+}
@@ -5,6 +5,10 @@
 // For a copy, see <https://opensource.org/licenses/MIT>.
 
 #include "Generation/PoissonDiscSampling.h"
+#include "Generation/PoissonDiscCache.h"
+#include "Generation/PoissonDiscSampler.h"
+#include "Generation/PoissonTileSet.h"
+#include "Generation/SpatialIndex2D.h"
 
 #include "PCGContext.h"
 #include "PCGComponent.h"
@@ -16,22 +20,21 @@
 #include "PCGPin.h"
 #include "Data/PCGPointData.h"
 #include "Data/PCGSplineData.h"
+#include "Helpers/PCGHelpers.h"
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include "CarlaMeshGeneration.h"
 
-#include <unordered_map>
 #include <algorithm>
-#include <optional>
 #include <atomic>
 #include <vector>
-#include <random>
-#include <array>
-#include <span>
-#include <bit>
 
 using RealT = float;
 using IntT = int32;
 using V2 = UE::Math::TVector2<RealT>;
 using I2 = FIntPoint;
-using Edge = std::pair<V2, V2>;
 
 UPCGPoissonDiscSamplingSettings::UPCGPoissonDiscSamplingSettings()
 {
@@ -46,24 +49,6 @@ TArray<FPCGPinProperties> UPCGPoissonDiscSamplingSettings::InputPinProperties()
   return Properties;
 }
 
-float GetZFromAlphaTable(const TArray<TPair<float, float>>& Table, float Alpha)
-{
-    for (int32 i = 1; i < Table.Num(); ++i)
-    {
-        if (Alpha <= Table[i].Key)
-        {
-            float Alpha1 = Table[i - 1].Key;
-            float Alpha2 = Table[i].Key;
-            float Z1 = Table[i - 1].Value;
-            float Z2 = Table[i].Value;
-
-            float T = FMath::Clamp((Alpha - Alpha1) / (Alpha2 - Alpha1), 0.0f, 1.0f);
-            return FMath::Lerp(Z1, Z2, T);
-        }
-    }
-    return Table.Last().Value;
-}
-
 TArray<FPCGPinProperties> UPCGPoissonDiscSamplingSettings::OutputPinProperties() const
 {
   return Super::DefaultPointOutputPinProperties();
@@ -74,316 +59,562 @@ FPCGElementPtr UPCGPoissonDiscSamplingSettings::CreateElement() const
   return MakeShared<FPCGPoissonDiscSampling>();
 }
 
-static RealT KahanDeterminant(
-  V2 u, V2 v)
+static uint64 ComputeSamplingKey(
+  TConstArrayView<V2> SplinePoints,
+  bool bClosed,
+  int32 Seed,
+  const UPCGPoissonDiscSamplingSettings& Settings)
 {
-  RealT
-    a = u.X, b = v.X,
-    c = u.Y, d = v.Y;
-  RealT w = b * c;
-  return std::fma(-b, c, w) + std::fma(a, d, -w);
+  struct
+  {
+    uint32 Version;
+    int32 Seed;
+    float MinDistance;
+    int32 MaxRetries;
+    uint8 bFilterInsideSpline;
+    uint8 bClosed;
+  } Header;
+  FMemory::Memzero(Header);
+  Header.Version = FPoissonDiscSampler::Version;
+  Header.Seed = Seed;
+  Header.MinDistance = Settings.MinDistance;
+  Header.MaxRetries = Settings.MaxRetries;
+  Header.bFilterInsideSpline = Settings.bFilterInsideSpline;
+  Header.bClosed = bClosed;
+
+  uint64 Hash = CityHash64((const char*)&Header, sizeof(Header));
+  return CityHash64WithSeed(
+    (const char*)SplinePoints.GetData(),
+    (uint32)(SplinePoints.Num() * sizeof(V2)),
+    Hash);
 }
 
-static bool IsInsideSpline(
-  std::span<Edge> Edges,
-  V2 point)
+// Returns the areas an edit from OldVertices to NewVertices may have changed.
+// A vertex of either polyline that is off the other one has moved, and the
+// area its segments swept lies in the box of the vertex and its neighbours.
+// Boxes are grown by Border and merged where they overlap.
+static TArray<FBox2f> ComputeDirtyBoxes(
+  TConstArrayView<FVector3f> OldVertices,
+  TConstArrayView<FVector3f> NewVertices,
+  bool bClosed,
+  float Tolerance,
+  float Border)
 {
-  double TotalAngle = 0.0;
+  TArray<FBox2f> Boxes;
 
-  for (const Edge& e : Edges)
-  {
-    V2 u = e.first - point;
-    V2 v = e.second - point;
+  auto AddMovedVertices = [&](TConstArrayView<FVector3f> Vertices, TConstArrayView<FVector3f> Other)
+    {
+      const FSegmentIndex2D OtherIndex(Other, bClosed);
+      const int32 Num = Vertices.Num();
+      for (int32 i = 0; i < Num; ++i)
+      {
+        const FVector2f Vertex(Vertices[i].X, Vertices[i].Y);
+        if (OtherIndex.GetDistanceSquared(Vertex) <= FMath::Square(Tolerance))
+          continue;
 
-    double det = u.X * v.Y - u.Y * v.X;
-    double dot = u.X * v.X + u.Y * v.Y;
-    double angle = std::atan2(det, dot);
+        FBox2f Box(ForceInit);
+        Box += Vertex;
+        for (int32 Neighbor : { i - 1, i + 1 })
+        {
+          if (bClosed)
+            Neighbor = (Neighbor + Num) % Num;
+          if (Neighbor >= 0 && Neighbor < Num)
+            Box += FVector2f(Vertices[Neighbor].X, Vertices[Neighbor].Y);
+        }
+        Boxes.Add(Box.ExpandBy(Border));
+      }
+    };
 
-    TotalAngle += angle;
-  }
+  AddMovedVertices(NewVertices, OldVertices);
+  AddMovedVertices(OldVertices, NewVertices);
 
-  // Winding number check: if abs(total angle) ~ 2*PI, we're inside
-  return FMath::Abs(TotalAngle) > PI;
+  // Merge until no two boxes overlap.
+  for (bool bMerged = true; bMerged; )
+  {
+    bMerged = false;
+    for (int32 i = 0; i < Boxes.Num(); ++i)
+    {
+      for (int32 j = Boxes.Num() - 1; j > i; --j)
+      {
+        if (Boxes[i].Intersect(Boxes[j]))
+        {
+          Boxes[i] += Boxes[j];
+          Boxes.RemoveAtSwap(j);
+          bMerged = true;
+        }
+      }
+    }
+  }
+  return Boxes;
 }
 
-static FBox ComputeSplineBoundingBox(
-  std::span<V2> Points)
+// Updates the points sampled for Previous to a spline edited into
+// SplineVertices: points away from the edit are kept, and the areas around
+// it are resampled with the kept points fixed. Returns false if a full
+// resample is the better choice.
+static bool ResampleEdit(
+  const FPoissonIncrementalStore::FEntry& Previous,
+  TConstArrayView<FVector3f> SplineVertices,
+  bool bClosed,
+  const FPoissonDiscSamplerParams& BaseParams,
+  TArray<FVector2f>& OutPoints)
 {
-  V2 Min, Max;
-  if (Points.empty())
-    return FBox();
-  Min = Points[0];
-  Max = Points[0];
-  for (std::size_t i = 1; i != Points.size(); ++i)
+  TRACE_CPUPROFILER_EVENT_SCOPE(PoissonDiscSampling::ResampleEdit);
+
+  // Without the polygon every point depends on the bounding box, so any
+  // change to it moves the edge of the sampled area.
+  FBox2f PreviousBounds(ForceInit);
+  for (const FVector3f& Vertex : Previous.SplineVertices)
+    PreviousBounds += FVector2f(Vertex.X, Vertex.Y);
+  if (BaseParams.Polygon == nullptr && PreviousBounds != BaseParams.Bounds)
+    return false;
+
+  // Points within MinDistance of a change may now be too close to a new
+  // point, so the border is one minimum distance on top of the edit itself.
+  const float MinDistance = BaseParams.MinDistance;
+  const TArray<FBox2f> DirtyBoxes = ComputeDirtyBoxes(
+    Previous.SplineVertices, SplineVertices, bClosed, MinDistance * 1e-3f, MinDistance);
+
+  // Past half the area there is little left to keep.
+  float DirtyArea = 0.0f;
+  for (const FBox2f& Box : DirtyBoxes)
+    DirtyArea += Box.GetArea();
+  if (DirtyArea > 0.5f * BaseParams.Bounds.GetArea())
+    return false;
+
+  auto IsDirty = [&](const FVector2f& Point)
+    {
+      return DirtyBoxes.ContainsByPredicate([&](const FBox2f& Box) { return Box.IsInsideOrOn(Point); });
+    };
+
+  OutPoints.Reset(Previous.Points.Num());
+  for (const FVector2f& Point : Previous.Points)
   {
-    Min = V2::Min(Min, Points[i]);
-    Max = V2::Max(Max, Points[i]);
+    if (!IsDirty(Point))
+      OutPoints.Add(Point);
   }
-  return FBox(FVector(Min.X, Min.Y, 0.0), FVector(Max.X, Max.Y, 0.0));
-}
 
-static std::vector<V2> GeneratePoissonDiscPoints(
-  FPCGContext* Context,
-  FBox SplineBB,
-  std::span<Edge> Edges,
-  float MinDistance,
-  const UPCGPoissonDiscSamplingSettings& Settings)
-{
-  std::random_device RD;
-  std::ranlux48 PRNG(RD());
-  std::uniform_real_distribution<RealT> URD(0, 1);
+  // The dirty boxes cover where the outline moved, but a kept point right at
+  // their border may still have changed sides, so the kept points are filtered
+  // with the new polygon like sampled ones are.
+  if (BaseParams.Polygon != nullptr && !BaseParams.Polygon->IsEmpty())
+  {
+    TArray<bool> Inside;
+    Inside.SetNumUninitialized(OutPoints.Num());
+    BaseParams.Polygon->ClassifyPoints(OutPoints, Inside);
+    int32 NumInside = 0;
+    for (int32 i = 0; i < OutPoints.Num(); ++i)
+    {
+      if (Inside[i])
+        OutPoints[NumInside++] = OutPoints[i];
+    }
+    OutPoints.SetNum(NumInside, EAllowShrinking::No);
+  }
+  const int32 NumKept = OutPoints.Num();
 
-  const RealT Sqrt2 = FMath::Sqrt((RealT)2);
-  const RealT Tau = (RealT)(2.0 * PI);
+  TArray<FVector2f> FixedPoints;
+  for (int32 BoxIndex = 0; BoxIndex < DirtyBoxes.Num(); ++BoxIndex)
+  {
+    const FBox2f Box(
+      FVector2f::Max(DirtyBoxes[BoxIndex].Min, BaseParams.Bounds.Min),
+      FVector2f::Min(DirtyBoxes[BoxIndex].Max, BaseParams.Bounds.Max));
+    if (Box.Min.X >= Box.Max.X || Box.Min.Y >= Box.Max.Y)
+      continue;
+
+    const FBox2f Neighborhood = Box.ExpandBy(MinDistance);
+    FixedPoints.Reset();
+    for (const FVector2f& Point : OutPoints)
+    {
+      if (Neighborhood.IsInsideOrOn(Point))
+        FixedPoints.Add(Point);
+    }
 
-  const V2 Min(SplineBB.Min.X, SplineBB.Min.Y);
-  const V2 Max(SplineBB.Max.X, SplineBB.Max.Y);
-  const V2 Extent = Max - Min;
+    FPoissonDiscSamplerParams Params = BaseParams;
+    Params.Bounds = Box;
+    Params.FixedPoints = FixedPoints;
+    Params.Seed = FPoissonRandom::Mix(BaseParams.Seed + (uint64)BoxIndex);
+    OutPoints.Append(FPoissonDiscSampler::Generate(Params));
+  }
 
-  const RealT R = (RealT)MinDistance;
-  const RealT R2 = R * R;
-  const IntT MaxRetries = Settings.MaxRetries;
+  UE_LOG(LogCarlaMeshGeneration, Verbose, TEXT("Poisson sampling kept %d of %d points and resampled %d areas."),
+    NumKept, Previous.Points.Num(), DirtyBoxes.Num());
+  return true;
+}
 
-  const RealT CellSize = R / Sqrt2;
-  const V2 GridFloat = Extent / CellSize;
-  const FIntPoint GridSize(FMath::CeilToInt(GridFloat.X), FMath::CeilToInt(GridFloat.Y));
-  const int32 CellCount = GridSize.X * GridSize.Y;
-  const bool UseBitMask = (4096 >= (CellCount / 8));
+// Spreads the low 32 bits of X over the even bits of the result.
+static uint64 SpreadMortonBits(uint64 X)
+{
+  X &= 0xFFFFFFFFull;
+  X = (X | (X << 16)) & 0x0000FFFF0000FFFFull;
+  X = (X | (X << 8)) & 0x00FF00FF00FF00FFull;
+  X = (X | (X << 4)) & 0x0F0F0F0F0F0F0F0Full;
+  X = (X | (X << 2)) & 0x3333333333333333ull;
+  X = (X | (X << 1)) & 0x5555555555555555ull;
+  return X;
+}
 
-  std::unordered_map<IntT, V2> Grid;
-  std::vector<bool> Occupancy;
-  if (UseBitMask)
-    Occupancy.resize(CellCount);
+// Reorders points along a Z-order curve over Bounds, so points close in the
+// sequence are close in space.
+static void SortByMortonOrder(TArray<FVector2f>& Points, const FBox2f& Bounds)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(PoissonDiscSampling::SortByMortonOrder);
 
-  auto GetRandomScalar = [&](RealT MinVal, RealT MaxVal)
-    {
-      return std::fma(URD(PRNG), MaxVal - MinVal, MinVal);
-    };
+  const FVector2d Min(Bounds.Min);
+  const FVector2d Size = FVector2d::Max(FVector2d(Bounds.GetSize()), FVector2d(UE_SMALL_NUMBER));
+  const FVector2d Scale = FVector2d((double)MAX_uint32) / Size;
 
-  auto GetRandomPoint = [&](V2 A, V2 B)
+  auto Quantize = [](double Value)
     {
-      return V2(
-        GetRandomScalar(A.X, B.X),
-        GetRandomScalar(A.Y, B.Y));
+      return (uint64)FMath::Clamp(Value, 0.0, (double)MAX_uint32);
     };
 
-  auto GridCoordToFlatIndex = [&](I2 Key)
+  TArray<TPair<uint64, int32>> Codes;
+  Codes.Reserve(Points.Num());
+  for (int32 i = 0; i < Points.Num(); ++i)
+  {
+    const FVector2d Cell = (FVector2d(Points[i]) - Min) * Scale;
+    const uint64 Code = SpreadMortonBits(Quantize(Cell.X)) | (SpreadMortonBits(Quantize(Cell.Y)) << 1);
+    Codes.Emplace(Code, i);
+  }
+  Codes.Sort([](const TPair<uint64, int32>& A, const TPair<uint64, int32>& B)
     {
-      return Key.X + Key.Y * GridSize.X;
-    };
+      return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+    });
+
+  TArray<FVector2f> Sorted;
+  Sorted.SetNumUninitialized(Points.Num());
+  for (int32 i = 0; i < Points.Num(); ++i)
+    Sorted[i] = Points[Codes[i].Value];
+  Points = MoveTemp(Sorted);
+}
 
-  auto GridQuery = [&](I2 Key) -> std::optional<V2>
-    {
-      const int32 Flat = GridCoordToFlatIndex(Key);
-      if (UseBitMask && !Occupancy[Flat])
-        return std::nullopt;
-      auto it = Grid.find(Flat);
-      if (it == Grid.end())
-        return std::nullopt;
-      return it->second;
-    };
+// Samples one spline and returns the points with their heights. Runs on a
+// worker thread, so it only reads the spline and settings. TileSet is only
+// used, and must be set, in tile set mode.
+static TArray<FVector> SampleSpline(
+  const UPCGSplineData* InputData,
+  const UPCGPoissonDiscSamplingSettings& Settings,
+  const FPoissonTileSetData* TileSet,
+  int32 Seed,
+  const FPoissonIncrementalStore::FKey& IncrementalKey,
+  const std::atomic<bool>& bCancelled)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(PoissonDiscSampling::SampleSpline);
 
-  auto GridAdd = [&](I2 Key, V2 Value)
-    {
-      const int32 Flat = GridCoordToFlatIndex(Key);
-      if (UseBitMask)
-        Occupancy[Flat] = true;
-      Grid[Flat] = Value;
-    };
+  // Sample points along the spline
+  int32 SampleCount = Settings.SplineSampleCount;
+  TArray<FVector3f> SplineVertices;
+  SplineVertices.Reserve(SampleCount);
 
-  std::vector<V2> Results2D;
-  std::vector<V2> Pending;
-  Results2D.reserve(CellCount);
-  Pending.reserve(CellCount);
-  Grid.reserve(CellCount);
+  std::vector<V2> SplinePoints;
+  SplinePoints.reserve(SampleCount);
 
-  V2 First = GetRandomPoint(Min, Max);
-  Results2D.push_back(First);
-  Pending.push_back(First);
+  FBox SplineBoundingBox(EForceInit::ForceInit);
 
-  while (!Pending.empty())
+  for (int32 i = 0; i < SampleCount; ++i)
   {
-    std::uniform_int_distribution<IntT> UID(0, (IntT)Pending.size() - 1);
-    IntT Index = UID(PRNG);
-    V2 Point = Pending[Index];
-    bool Found = false;
+    float Alpha = static_cast<float>(i) / static_cast<float>(SampleCount - 1);
 
-    for (IntT i = 0; i < MaxRetries; ++i)
-    {
-      const RealT Theta = GetRandomScalar(0, Tau);
-      const RealT Rho = GetRandomScalar(R, 2 * R);
-      V2 SinCos;
-      FMath::SinCos(&SinCos.Y, &SinCos.X, Theta);
-      V2 NewPoint = Point + Rho * SinCos;
-
-      if (NewPoint.X < Min.X || NewPoint.X >= Max.X ||
-        NewPoint.Y < Min.Y || NewPoint.Y >= Max.Y)
-        continue;
+    // Local spline position (used for filtering and bounds)
+    FVector LocalPos = InputData->GetLocationAtAlpha(Alpha);
+    SplinePoints.emplace_back(LocalPos.X, LocalPos.Y);
+    SplineBoundingBox += FVector(LocalPos.X, LocalPos.Y, LocalPos.Z);
+    SplineVertices.Emplace(LocalPos);
+  }
 
-      V2 Tmp = (NewPoint - Min) / CellSize;
-      I2 GridCoord((IntT)Tmp.X, (IntT)Tmp.Y);
+  // Build the polygon index. Open splines are closed implicitly, since the
+  // inside test needs an area.
+  const FPolygonIndex2D SplinePolygon(MakeArrayView(SplinePoints.data(), (int32)SplinePoints.size()));
 
-      const I2 Offsets[] =
-      {
-        I2(-2,-2), I2(-1,-2), I2(0,-2), I2(1,-2), I2(2,-2),
-        I2(-2,-1), I2(-1,-1), I2(0,-1), I2(1,-1), I2(2,-1),
-        I2(-2, 0), I2(-1, 0), I2(0, 0), I2(1, 0), I2(2, 0),
-        I2(-2, 1), I2(-1, 1), I2(0, 1), I2(1, 1), I2(2, 1),
-        I2(-2, 2), I2(-1, 2), I2(0, 2), I2(1, 2), I2(2, 2)
-      };
-
-      std::vector<I2> TestPositions;
-      TestPositions.reserve(25);
-      for (I2 Offset : Offsets)
-      {
-        I2 Test = GridCoord + Offset;
-        if (Test.X >= 0 && Test.Y >= 0 && Test.X < GridSize.X && Test.Y < GridSize.Y)
-          TestPositions.push_back(Test);
-      }
+  const FBox2f SamplingBounds(
+    FVector2f(SplineBoundingBox.Min.X, SplineBoundingBox.Min.Y),
+    FVector2f(SplineBoundingBox.Max.X, SplineBoundingBox.Max.Y));
+  const FPolygonIndex2D* FilterPolygon = Settings.bFilterInsideSpline ? &SplinePolygon : nullptr;
 
-      bool OK = true;
-      for (I2 Test : TestPositions)
-      {
-        auto Neighbor = GridQuery(Test);
-        if (Neighbor && V2::DistSquared(NewPoint, *Neighbor) < R2)
-        {
-          OK = false;
-          break;
-        }
-      }
+  TArray<FVector2f> Results2D;
+  if (Settings.SamplingMode == EPoissonDiscSamplingMode::TileSet)
+  {
+    // Stamping tiles costs little more than copying the points, so there is
+    // nothing worth caching.
+    check(TileSet);
+    TileSet->Stamp(SamplingBounds, Settings.MinDistance, (uint64)Seed, FilterPolygon, Results2D);
+  }
+  else
+  {
+    // The same spline, seed and settings always produce the same points, so
+    // they can be served from the persistent cache.
+    const uint64 SamplingKey = ComputeSamplingKey(
+      MakeArrayView(SplinePoints.data(), (int32)SplinePoints.size()), InputData->IsClosed(), Seed, Settings);
+
+    FPoissonDiscSamplerParams Params;
+    Params.Bounds = SamplingBounds;
+    Params.Polygon = FilterPolygon;
+    Params.MinDistance = Settings.MinDistance;
+    Params.MaxRetries = Settings.MaxRetries;
+    Params.Seed = SamplingKey;
+    Params.bParallel = Settings.bParallelSampling;
+    Params.GridMemoryBudgetMB = Settings.GridMemoryBudgetMB;
+    Params.bCancelled = &bCancelled;
+
+    // The polygon used for filtering is closed even for open splines, so
+    // edits must be tracked along its closing edge too.
+    const bool bClosedOutline = InputData->IsClosed() || FilterPolygon != nullptr;
+
+    // Points from the previous run of the same input only carry over if they
+    // were sampled with the same seed and settings.
+    const bool bIncremental = Settings.bIncrementalResampling && IncrementalKey.IsSet();
+    const uint64 SettingsKey = bIncremental ? ComputeSamplingKey({}, bClosedOutline, Seed, Settings) : 0;
+    const TSharedPtr<const FPoissonIncrementalStore::FEntry> Previous = bIncremental ?
+      FPoissonIncrementalStore::Get().Find(IncrementalKey) :
+      nullptr;
+
+    if (Previous && Previous->SettingsKey == SettingsKey &&
+      ResampleEdit(*Previous, SplineVertices, bClosedOutline, Params, Results2D))
+    {
+      if (bCancelled.load(std::memory_order_relaxed))
+        return {};
+    }
+    else if (!Settings.bUsePointCache || !FPoissonDiscCache::Get().Load(SamplingKey, Results2D))
+    {
+      // Generate Poisson points, only inside the spline when filtering
+      Results2D = FPoissonDiscSampler::Generate(Params);
 
-      if (OK)
-      {
-        Results2D.push_back(NewPoint);
-        Pending.push_back(NewPoint);
-        GridAdd(GridCoord, NewPoint);
-        Found = true;
-        break;
-      }
+      // A cancelled run stops early, so its points must not be cached.
+      if (bCancelled.load(std::memory_order_relaxed))
+        return {};
+
+      if (Settings.bUsePointCache)
+        FPoissonDiscCache::Get().Store(SamplingKey, Results2D);
     }
 
-    if (!Found)
-      Pending.erase(Pending.begin() + Index);
+    if (bIncremental)
+    {
+      const TSharedRef<FPoissonIncrementalStore::FEntry> Entry = MakeShared<FPoissonIncrementalStore::FEntry>();
+      Entry->SettingsKey = SettingsKey;
+      Entry->SplineVertices = SplineVertices;
+      Entry->Points = Results2D;
+      FPoissonIncrementalStore::Get().Store(IncrementalKey, Entry);
+    }
   }
 
-  return Results2D;
+  if (Settings.bSortByMortonOrder)
+    SortByMortonOrder(Results2D, SamplingBounds);
+
+  // Each point takes the height of the closest point on the sampled spline,
+  // interpolated along its segment.
+  const FSegmentIndex2D SplineSegments(SplineVertices, InputData->IsClosed());
+  TArray<float> ResultsZ;
+  ResultsZ.SetNumUninitialized(Results2D.Num());
+  SplineSegments.GetZ(Results2D, ResultsZ);
+
+  TArray<FVector> Points;
+  Points.SetNumUninitialized(Results2D.Num());
+  for (int32 i = 0; i < Points.Num(); ++i)
+    Points[i] = FVector(Results2D[i].X, Results2D[i].Y, ResultsZ[i]);
+  return Points;
 }
 
-bool FPCGPoissonDiscSampling::ExecuteInternal(
-  FPCGContext* Context) const
-{ 
-  const UPCGPoissonDiscSamplingSettings* SettingsPtr = Context->GetInputSettings<UPCGPoissonDiscSamplingSettings>();
-  check(SettingsPtr);
+// Identifies a spline input of a node across executions, so edits to the
+// spline can be resampled incrementally. The node is identified by its path,
+// which unlike its address is never reused by another node.
+static FPoissonIncrementalStore::FKey ComputeIncrementalKey(const FPCGContext* Context, int32 InputIndex)
+{
+  const UPCGComponent* Component = Context->SourceComponent.Get();
+  if (Component == nullptr || Context->Node == nullptr)
+    return {};
 
-  auto Inputs = Context->InputData.GetInputsByPin(PCGPinConstants::DefaultInputLabel);
-  float MinDistance = SettingsPtr->MinDistance;
+  const FString NodePath = Context->Node->GetPathName();
+  const uint64 NodeHash = CityHash64((const char*)*NodePath, NodePath.Len() * sizeof(TCHAR));
+  return { FObjectKey(Component), CityHash64WithSeed((const char*)&InputIndex, sizeof(InputIndex), NodeHash) };
+}
 
-  for (FPCGTaggedData& Input : Inputs)
-  {
-    const UPCGSplineData* InputData = Cast<UPCGSplineData>(Input.Data);
-    if (!InputData)
+// Builds the output point data. Point properties are filled in parallel, and
+// the metadata entries and Density values are added in single bulk calls.
+static UPCGSpatialData* BuildPointData(
+  FPCGContext* Context,
+  const UPCGSplineData* InputData,
+  TConstArrayView<FVector> Points)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(PoissonDiscSampling::BuildPointData);
+
+  const int32 NumPoints = Points.Num();
+  TArray<float> Densities;
+  Densities.SetNumUninitialized(NumPoints);
+
+  // Seeds follow the position, like points sampled by the built-in nodes,
+  // so the Density attribute varies between points.
+  auto InitPoint = [&](int32 Index, FTransform& Transform, int32& Seed)
     {
-        UE_LOG(LogTemp, Warning, TEXT("Invalid spline input."));
-        continue;
-    }
+      Transform = FTransform(Points[Index]);
+      Seed = PCGHelpers::ComputeSeedFromPosition(Points[Index]);
+      Densities[Index] = FRandomStream(Seed).GetFraction();
+    };
 
-    // Transform bounding box to world space
-    FTransform SplineTransform = InputData->GetTransform();
-    // Sample points along the spline
-    int32 SampleCount = SettingsPtr->SplineSampleCount;
-    TArray<TPair<float, FVector>> SplineAlphaTable;
-    SplineAlphaTable.Reserve(SampleCount);
+  TArray<PCGMetadataEntryKey*> EntryKeys;
+  EntryKeys.SetNumUninitialized(NumPoints);
+
+#if ENGINE_MAJOR_VERSION > 5 || ENGINE_MINOR_VERSION >= 6
+  // Struct-of-arrays point data: every property is a separate array.
+  UPCGBasePointData* Output = FPCGContext::NewPointData_AnyThread(Context);
+  Output->InitializeFromData(InputData);
+  Output->SetNumPoints(NumPoints, /*bInitializeValues=*/false);
+  Output->AllocateProperties(
+    EPCGPointNativeProperties::Transform |
+    EPCGPointNativeProperties::Seed |
+    EPCGPointNativeProperties::MetadataEntry);
+
+  TPCGValueRange<FTransform> Transforms = Output->GetTransformValueRange(/*bAllocate=*/false);
+  TPCGValueRange<int32> Seeds = Output->GetSeedValueRange(/*bAllocate=*/false);
+  TPCGValueRange<int64> Entries = Output->GetMetadataEntryValueRange(/*bAllocate=*/false);
+  ParallelFor(NumPoints, [&](int32 Index)
+    {
+      InitPoint(Index, Transforms[Index], Seeds[Index]);
+      Entries[Index] = PCGInvalidEntryKey;
+      EntryKeys[Index] = &Entries[Index];
+    });
+
+  UPCGMetadata* Metadata = Output->MutableMetadata();
+#else
+  UPCGPointData* Output = FPCGContext::NewObject_AnyThread<UPCGPointData>(Context);
+  Output->InitializeFromData(InputData);
+  TArray<FPCGPoint>& OutputPoints = Output->GetMutablePoints();
+  OutputPoints.SetNum(NumPoints);
+  ParallelFor(NumPoints, [&](int32 Index)
+    {
+      FPCGPoint& Point = OutputPoints[Index];
+      InitPoint(Index, Point.Transform, Point.Seed);
+      EntryKeys[Index] = &Point.MetadataEntry;
+    });
 
-    std::vector<V2> SplinePoints;
-    SplinePoints.reserve(SampleCount);
+  UPCGMetadata* Metadata = Output->Metadata;
+#endif
+  check(Metadata);
 
-    FBox SplineBoundingBox(EForceInit::ForceInit);
+  // Create metadata attribute for random float
+  FName AttributeName = TEXT("Density");
+  FPCGMetadataAttribute<float>* RandomAttr = Metadata->CreateAttribute<float>(
+    AttributeName, 0.0f, /* bAllowsInterpolation = */ true, /* bOverrideParent = */ false);
 
-    for (int32 i = 0; i < SampleCount; ++i)
-    {
-        float Alpha = static_cast<float>(i) / static_cast<float>(SampleCount - 1);
+  Metadata->AddEntriesInPlace(EntryKeys);
 
-        // Local spline position (used for filtering and bounds)
-        FVector LocalPos = InputData->GetLocationAtAlpha(Alpha);
-        SplinePoints.emplace_back(LocalPos.X, LocalPos.Y);
-        SplineBoundingBox += FVector(LocalPos.X, LocalPos.Y, LocalPos.Z);
+  TArray<PCGMetadataEntryKey> Keys;
+  Keys.SetNumUninitialized(NumPoints);
+  for (int32 Index = 0; Index < NumPoints; ++Index)
+    Keys[Index] = *EntryKeys[Index];
+  RandomAttr->SetValues(Keys, Densities);
 
-        // World position (used for Z height and placing points)
-        FVector WorldPos = InputData->GetTransform().TransformPosition(LocalPos);
-        SplineAlphaTable.Emplace(Alpha, LocalPos);
-    }
+  return Output;
+}
 
-    // Build polygon edges
-    std::vector<Edge> SplineEdges;
-    for (size_t i = 0; i + 1 < SplinePoints.size(); ++i)
-        SplineEdges.emplace_back(SplinePoints[i], SplinePoints[i + 1]);
-    if (InputData->IsClosed() && SplinePoints.size() > 2)
-        SplineEdges.emplace_back(SplinePoints.back(), SplinePoints.front());
-
-    // Generate Poisson points
-    std::vector<V2> Results2D = GeneratePoissonDiscPoints(
-        Context, SplineBoundingBox, SplineEdges, SettingsPtr->MinDistance, *SettingsPtr);
-
-    // Filter inside spline
-    Results2D.erase(std::remove_if(Results2D.begin(), Results2D.end(),
-        [&](const V2& Point) { return !IsInsideSpline(SplineEdges, Point); }),
-        Results2D.end());
-
-    // Build output data
-    UPCGPointData* Output = FPCGContext::NewObject_AnyThread<UPCGPointData>(Context);
-    Output->InitializeFromData(InputData);
-    auto& OutputPoints = Output->GetMutablePoints();
-    OutputPoints.Reserve(Results2D.size());
-
-    // Ensure metadata is initialized
-    UPCGMetadata* Metadata = Output->Metadata;
-    check(Metadata);
-
-    // Create metadata attribute for random float
-    FName AttributeName = TEXT("Density");
-    FPCGMetadataAttribute<float>* RandomAttr = Metadata->CreateAttribute<float>(
-        AttributeName, 0.0f, /* bAllowsInterpolation = */ true, /* bOverrideParent = */ false);
-    for (const V2& P : Results2D)
-    {
-        FVector2D Target2D(P.X, P.Y);
+FPCGPoissonDiscSamplingContext::~FPCGPoissonDiscSamplingContext()
+{
+  // Jobs reference the context, so they must finish before it goes away.
+  bCancelled = true;
+  for (FSplineJob& Job : Jobs)
+    Job.Task.Wait();
+}
 
-        // Find closest point in the table
-        float ClosestDistSqr = FLT_MAX;
-        float BestAlpha = 0.0f;
-        FVector BestWorldPos = FVector::ZeroVector;
+bool FPCGPoissonDiscSampling::ExecuteInternal(
+  FPCGContext* InContext) const
+{
+  FPCGPoissonDiscSamplingContext* Context = static_cast<FPCGPoissonDiscSamplingContext*>(InContext);
+  check(Context);
 
-        for (const TPair<float, FVector>& Entry : SplineAlphaTable)
-        {
-            const FVector2D Table2D(Entry.Value.X, Entry.Value.Y);
-            float DistSqr = FVector2D::DistSquared(Target2D, Table2D);
-
-            if (DistSqr < ClosestDistSqr)
-            {
-                ClosestDistSqr = DistSqr;
-                BestAlpha = Entry.Key;
-                BestWorldPos = Entry.Value;
-            }
-        }
+  const UPCGPoissonDiscSamplingSettings* SettingsPtr = Context->GetInputSettings<UPCGPoissonDiscSamplingSettings>();
+  check(SettingsPtr);
 
-        // Build PCG point
-        FPCGPoint Point;
-        FVector WorldPoint = FVector(Target2D.X, Target2D.Y, BestWorldPos.Z);
-        Point.Transform.SetLocation(WorldPoint);
+  if (!Context->bJobsCreated)
+  {
+    Context->bJobsCreated = true;
 
-        // Add metadata
-        Point.MetadataEntry = Metadata->AddEntry();
-        float RandomValue = FRandomStream(Point.Seed).GetFraction();
-        RandomAttr->SetValue(Point.MetadataEntry, RandomValue);
+    for (const FPCGTaggedData& Input : Context->InputData.GetInputsByPin(PCGPinConstants::DefaultInputLabel))
+    {
+      const UPCGSplineData* InputData = Cast<UPCGSplineData>(Input.Data);
+      if (!InputData)
+      {
+        UE_LOG(LogCarlaMeshGeneration, Warning, TEXT("Invalid spline input."));
+        continue;
+      }
+      FPCGPoissonDiscSamplingContext::FSplineJob& Job = Context->Jobs.AddDefaulted_GetRef();
+      Job.Spline = InputData;
+      Job.IncrementalKey = ComputeIncrementalKey(Context, Context->Jobs.Num() - 1);
+    }
+
+    // Jobs read the tile set from a copy owned by the context, so the asset
+    // is only touched here, on the game thread.
+    if (SettingsPtr->SamplingMode == EPoissonDiscSamplingMode::TileSet)
+    {
+      const UPoissonTileSet* TileSetAsset = SettingsPtr->TileSet.LoadSynchronous();
+      if (TileSetAsset && TileSetAsset->Data.IsValid())
+      {
+        Context->TileSet = MakeShared<const FPoissonTileSetData>(TileSetAsset->Data);
+      }
+      else
+      {
+        if (!SettingsPtr->TileSet.IsNull())
+          UE_LOG(LogCarlaMeshGeneration, Warning, TEXT("Poisson tile set %s is empty, using the default tile set."), *SettingsPtr->TileSet.ToString());
+        Context->TileSet = FPoissonTileSetData::GetDefault();
+      }
+    }
+
+    // Splines are independent, so each one is sampled by its own task. Jobs
+    // write only to their own entry, and the array is not resized after this.
+    if (SettingsPtr->bParallelSampling)
+    {
+      const int32 Seed = Context->GetSeed();
+      for (FPCGPoissonDiscSamplingContext::FSplineJob& Job : Context->Jobs)
+      {
+        Job.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Job, SettingsPtr, TileSet = Context->TileSet.Get(), Seed, &bCancelled = Context->bCancelled]()
+          {
+            Job.Points = SampleSpline(Job.Spline, *SettingsPtr, TileSet, Seed, Job.IncrementalKey, bCancelled);
+          });
+      }
+    }
+  }
 
-        OutputPoints.Add(Point);
+  // Outputs are emitted strictly in input order as jobs complete, yielding
+  // whenever the next one is still running or the frame budget is spent.
+  while (Context->NextJobToOutput < Context->Jobs.Num())
+  {
+    FPCGPoissonDiscSamplingContext::FSplineJob& Job = Context->Jobs[Context->NextJobToOutput];
+    if (SettingsPtr->bParallelSampling)
+    {
+      if (!Job.Task.IsCompleted())
+        return false;
+    }
+    else
+    {
+      Job.Points = SampleSpline(Job.Spline, *SettingsPtr, Context->TileSet.Get(), Context->GetSeed(), Job.IncrementalKey, Context->bCancelled);
     }
 
-    // Add to output tagged data (per spline)
+    if (Context->bCancelled)
+      return true;
+
     FPCGTaggedData& TaggedOutput = Context->OutputData.TaggedData.Emplace_GetRef();
     TaggedOutput.Pin = PCGPinConstants::DefaultOutputLabel;  // Safe default
-    TaggedOutput.Data = Output;
-  }
+    TaggedOutput.Data = BuildPointData(Context, Job.Spline, Job.Points);
 
+    // The points now live in the output data.
+    Job.Points.Empty();
+    ++Context->NextJobToOutput;
+
+    if (Context->NextJobToOutput < Context->Jobs.Num() && Context->ShouldStop())
+      return false;
+  }
 
   return true;
 }
+
+bool FPCGPoissonDiscSampling::CanExecuteOnlyOnMainThread(FPCGContext* InContext) const
+{
+  // Loading the tile set asset needs the game thread. It happens before any
+  // job is created, and the sampling itself still runs in tasks.
+  const UPCGPoissonDiscSamplingSettings* SettingsPtr = InContext ? InContext->GetInputSettings<UPCGPoissonDiscSamplingSettings>() : nullptr;
+  return SettingsPtr && SettingsPtr->SamplingMode == EPoissonDiscSamplingMode::TileSet && !SettingsPtr->TileSet.IsNull();
+}
+
+void FPCGPoissonDiscSampling::AbortInternal(FPCGContext* InContext) const
+{
+  if (FPCGPoissonDiscSamplingContext* Context = static_cast<FPCGPoissonDiscSamplingContext*>(InContext))
+    Context->bCancelled = true;
+}
@@ -0,0 +1,290 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/PoissonTileSet.h"
+#include "Generation/PoissonDiscSampler.h"
+#include "Generation/SpatialIndex2D.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include "CarlaMeshGeneration.h"
+
+namespace
+{
+  // Patch layout around a lattice vertex, in units of the minimum distance.
+  // Corner patches cover the square of half side CornerExtent around their
+  // vertex. Edge patches cover a band of half width EdgeExtent between the
+  // corner squares, so the bands of two edges meeting at a vertex are at
+  // least sqrt(2) apart. Interiors keep HalfGap from their cell border, so
+  // interiors of neighbouring cells are at least one apart. Every other pair
+  // of patches that can come closer than one is generated one around the
+  // other.
+  constexpr float CornerExtent = 2.0f;
+  constexpr float EdgeExtent = 1.0f;
+  constexpr float HalfGap = 0.5f;
+  constexpr float MinTileSize = 6.0f;
+
+  enum class EPatchKind : uint64
+  {
+    Corner,
+    HorizontalEdge,
+    VerticalEdge,
+    Interior,
+    VertexColor,
+    HorizontalVariant,
+    VerticalVariant
+  };
+
+  uint64 HashPatch(uint64 Seed, EPatchKind Kind, uint64 Index)
+  {
+    return FPoissonRandom::Mix(Seed + FPoissonRandom::Mix(((uint64)Kind << 56) ^ Index));
+  }
+
+  uint64 HashLattice(uint64 Seed, EPatchKind Kind, int32 X, int32 Y)
+  {
+    return HashPatch(Seed, Kind, (uint64)(uint32)X | ((uint64)(uint32)Y << 32));
+  }
+
+  int32 PickVariant(uint64 Hash, int32 Count)
+  {
+    return (int32)(((Hash >> 32) * (uint64)Count) >> 32);
+  }
+
+  // Samples the rectangle Region around the already placed points in Fixed.
+  TArray<FVector2f> SamplePatch(
+    const FBox2f& Region,
+    TConstArrayView<FVector2f> Fixed,
+    uint64 Seed,
+    int32 MaxRetries)
+  {
+    FPoissonDiscSamplerParams Params;
+    Params.Bounds = Region;
+    Params.FixedPoints = Fixed;
+    Params.MinDistance = 1.0f;
+    Params.MaxRetries = MaxRetries;
+    Params.Seed = Seed;
+    Params.bParallel = false;
+    return FPoissonDiscSampler::Generate(Params);
+  }
+
+  void AppendOffset(TArray<FVector2f>& Out, const FPoissonTilePatch& Patch, FVector2f Offset)
+  {
+    for (const FVector2f& Point : Patch.Points)
+      Out.Add(Point + Offset);
+  }
+}
+
+bool FPoissonTileSetData::IsValid() const
+{
+  if (TileSize < MinTileSize || NumCornerColors < 1 || NumEdgeVariants < 1)
+    return false;
+  const int32 NumEdges = NumCornerColors * NumCornerColors * NumEdgeVariants;
+  const int32 NumInteriors = FMath::Square(NumCornerColors * NumCornerColors * NumEdgeVariants * NumEdgeVariants);
+  return Corners.Num() == NumCornerColors &&
+    HorizontalEdges.Num() == NumEdges &&
+    VerticalEdges.Num() == NumEdges &&
+    Interiors.Num() == NumInteriors;
+}
+
+FPoissonTileSetData FPoissonTileSetData::Generate(
+  uint64 Seed,
+  float InTileSize,
+  int32 InNumCornerColors,
+  int32 InNumEdgeVariants,
+  int32 MaxRetries)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(FPoissonTileSetData::Generate);
+
+  FPoissonTileSetData Data;
+  Data.TileSize = FMath::Max(InTileSize, MinTileSize);
+  Data.NumCornerColors = FMath::Max(InNumCornerColors, 1);
+  Data.NumEdgeVariants = FMath::Max(InNumEdgeVariants, 1);
+
+  const float T = Data.TileSize;
+  const int32 K = Data.NumCornerColors;
+  const int32 E = Data.NumEdgeVariants;
+  const int32 NumEdges = K * K * E;
+  Data.Corners.SetNum(K);
+  Data.HorizontalEdges.SetNum(NumEdges);
+  Data.VerticalEdges.SetNum(NumEdges);
+  Data.Interiors.SetNum(FMath::Square(K * K * E * E));
+
+  // Corners first, then the edges between them, then the interiors between
+  // the edges. Patches of the same stage never come closer than one.
+  const FBox2f CornerRegion(FVector2f(-CornerExtent), FVector2f(CornerExtent));
+  ParallelFor(K, [&](int32 Color)
+    {
+      Data.Corners[Color].Points = SamplePatch(CornerRegion, {}, HashPatch(Seed, EPatchKind::Corner, Color), MaxRetries);
+    });
+
+  const FBox2f HorizontalRegion(FVector2f(CornerExtent, -EdgeExtent), FVector2f(T - CornerExtent, EdgeExtent));
+  const FBox2f VerticalRegion(FVector2f(-EdgeExtent, CornerExtent), FVector2f(EdgeExtent, T - CornerExtent));
+  ParallelFor(2 * NumEdges, [&](int32 Index)
+    {
+      const bool bVertical = Index >= NumEdges;
+      const int32 EdgeIndex = Index % NumEdges;
+      const int32 StartColor = EdgeIndex / (K * E);
+      const int32 EndColor = (EdgeIndex / E) % K;
+      const FVector2f EndOffset = bVertical ? FVector2f(0.0f, T) : FVector2f(T, 0.0f);
+
+      TArray<FVector2f> Fixed = Data.Corners[StartColor].Points;
+      AppendOffset(Fixed, Data.Corners[EndColor], EndOffset);
+
+      TArray<FPoissonTilePatch>& Edges = bVertical ? Data.VerticalEdges : Data.HorizontalEdges;
+      Edges[EdgeIndex].Points = SamplePatch(
+        bVertical ? VerticalRegion : HorizontalRegion,
+        Fixed,
+        HashPatch(Seed, bVertical ? EPatchKind::VerticalEdge : EPatchKind::HorizontalEdge, EdgeIndex),
+        MaxRetries);
+    });
+
+  const FBox2f InteriorRegion(FVector2f(HalfGap), FVector2f(T - HalfGap));
+  ParallelFor(Data.Interiors.Num(), [&](int32 InteriorIndex)
+    {
+      // Decode the index in the order GetInteriorIndex encodes it.
+      int32 CornerColors[4];
+      int32 EdgeVariants[4];
+      int32 Remainder = InteriorIndex;
+      for (int32 i = 3; i >= 0; --i)
+      {
+        EdgeVariants[i] = Remainder % E;
+        Remainder /= E;
+      }
+      for (int32 i = 3; i >= 0; --i)
+      {
+        CornerColors[i] = Remainder % K;
+        Remainder /= K;
+      }
+      check(Data.GetInteriorIndex(CornerColors, EdgeVariants) == InteriorIndex);
+
+      TArray<FVector2f> Fixed;
+      AppendOffset(Fixed, Data.Corners[CornerColors[0]], FVector2f(0.0f, 0.0f));
+      AppendOffset(Fixed, Data.Corners[CornerColors[1]], FVector2f(T, 0.0f));
+      AppendOffset(Fixed, Data.Corners[CornerColors[2]], FVector2f(T, T));
+      AppendOffset(Fixed, Data.Corners[CornerColors[3]], FVector2f(0.0f, T));
+      AppendOffset(Fixed, Data.HorizontalEdges[Data.GetEdgeIndex(CornerColors[0], CornerColors[1], EdgeVariants[0])], FVector2f(0.0f, 0.0f));
+      AppendOffset(Fixed, Data.VerticalEdges[Data.GetEdgeIndex(CornerColors[1], CornerColors[2], EdgeVariants[1])], FVector2f(T, 0.0f));
+      AppendOffset(Fixed, Data.HorizontalEdges[Data.GetEdgeIndex(CornerColors[3], CornerColors[2], EdgeVariants[2])], FVector2f(0.0f, T));
+      AppendOffset(Fixed, Data.VerticalEdges[Data.GetEdgeIndex(CornerColors[0], CornerColors[3], EdgeVariants[3])], FVector2f(0.0f, 0.0f));
+
+      Data.Interiors[InteriorIndex].Points = SamplePatch(
+        InteriorRegion, Fixed, HashPatch(Seed, EPatchKind::Interior, InteriorIndex), MaxRetries);
+    });
+
+  return Data;
+}
+
+TSharedRef<const FPoissonTileSetData> FPoissonTileSetData::GetDefault()
+{
+  static const TSharedRef<const FPoissonTileSetData> Default =
+    MakeShared<const FPoissonTileSetData>(Generate(0));
+  return Default;
+}
+
+void FPoissonTileSetData::Stamp(
+  const FBox2f& Bounds,
+  float MinDistance,
+  uint64 Seed,
+  const FPolygonIndex2D* Polygon,
+  TArray<FVector2f>& OutPoints) const
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(FPoissonTileSetData::Stamp);
+
+  if (!IsValid() || !Bounds.bIsValid || MinDistance <= 0.0f)
+    return;
+
+  // A cell also owns the corner patch at its lower left vertex, which
+  // reaches back into the previous cells, so one more cell is visited past
+  // the upper bounds.
+  const float CellSize = TileSize * MinDistance;
+  const FIntPoint CellMin(
+    FMath::FloorToInt(Bounds.Min.X / CellSize),
+    FMath::FloorToInt(Bounds.Min.Y / CellSize));
+  const FIntPoint CellMax(
+    FMath::FloorToInt(Bounds.Max.X / CellSize) + 1,
+    FMath::FloorToInt(Bounds.Max.Y / CellSize) + 1);
+  const int64 NumCells = (int64)(CellMax.X - CellMin.X + 1) * (int64)(CellMax.Y - CellMin.Y + 1);
+  if (NumCells > (int64)MAX_int32)
+  {
+    UE_LOG(LogCarlaMeshGeneration, Error, TEXT("Poisson tile stamping area is too large (%lld tiles)."), NumCells);
+    return;
+  }
+
+  auto GetColor = [&](int32 X, int32 Y)
+    {
+      return PickVariant(HashLattice(Seed, EPatchKind::VertexColor, X, Y), NumCornerColors);
+    };
+
+  auto GetVariant = [&](EPatchKind Kind, int32 X, int32 Y)
+    {
+      return PickVariant(HashLattice(Seed, Kind, X, Y), NumEdgeVariants);
+    };
+
+  // Rows of cells are stamped in parallel and concatenated in order, so the
+  // output does not depend on the thread count.
+  TArray<TArray<FVector2f>> RowPoints;
+  RowPoints.SetNum(CellMax.Y - CellMin.Y + 1);
+  ParallelFor(RowPoints.Num(), [&](int32 Row)
+    {
+      const int32 Y = CellMin.Y + Row;
+      TArray<FVector2f>& Points = RowPoints[Row];
+
+      auto Emit = [&](const FPoissonTilePatch& Patch, FVector2f Origin)
+        {
+          for (const FVector2f& Local : Patch.Points)
+          {
+            const FVector2f Point = Origin + Local * MinDistance;
+            if (Bounds.IsInside(Point) && (Polygon == nullptr || Polygon->IsInside(Point)))
+              Points.Add(Point);
+          }
+        };
+
+      for (int32 X = CellMin.X; X <= CellMax.X; ++X)
+      {
+        const int32 CornerColors[4] = {
+          GetColor(X, Y),
+          GetColor(X + 1, Y),
+          GetColor(X + 1, Y + 1),
+          GetColor(X, Y + 1)
+        };
+        const int32 EdgeVariants[4] = {
+          GetVariant(EPatchKind::HorizontalVariant, X, Y),
+          GetVariant(EPatchKind::VerticalVariant, X + 1, Y),
+          GetVariant(EPatchKind::HorizontalVariant, X, Y + 1),
+          GetVariant(EPatchKind::VerticalVariant, X, Y)
+        };
+
+        const FVector2f Origin((float)X * CellSize, (float)Y * CellSize);
+        Emit(Corners[CornerColors[0]], Origin);
+        Emit(HorizontalEdges[GetEdgeIndex(CornerColors[0], CornerColors[1], EdgeVariants[0])], Origin);
+        Emit(VerticalEdges[GetEdgeIndex(CornerColors[0], CornerColors[3], EdgeVariants[3])], Origin);
+        Emit(Interiors[GetInteriorIndex(CornerColors, EdgeVariants)], Origin);
+      }
+    });
+
+  int32 Total = OutPoints.Num();
+  for (const TArray<FVector2f>& Points : RowPoints)
+    Total += Points.Num();
+  OutPoints.Reserve(Total);
+  for (const TArray<FVector2f>& Points : RowPoints)
+    OutPoints.Append(Points);
+}
+
+void UPoissonTileSet::Generate()
+{
+  const double StartTime = FPlatformTime::Seconds();
+  Modify();
+  Data = FPoissonTileSetData::Generate((uint64)(uint32)Seed, TileSize, NumCornerColors, NumEdgeVariants, MaxRetries);
+  MarkPackageDirty();
+
+  int32 NumPoints = 0;
+  for (const FPoissonTilePatch& Patch : Data.Interiors)
+    NumPoints += Patch.Points.Num();
+  UE_LOG(LogCarlaMeshGeneration, Log, TEXT("Generated %d Poisson tiles (%d interior points) in %.3f s."),
+    Data.Interiors.Num(), NumPoints, FPlatformTime::Seconds() - StartTime);
+}
@@ -0,0 +1,297 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/ProceduralMeshChunking.h"
+
+#include "Async/ParallelFor.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include "CarlaMeshGeneration.h"
+
+namespace
+{
+  struct FClipVertex
+  {
+    FVector Position;
+    FVector Normal;
+    FVector2D UV;
+    FLinearColor Color;
+    FProcMeshTangent Tangent;
+
+    /** The input vertex this is, or INDEX_NONE for a vertex made by a cut. */
+    int32 Source = INDEX_NONE;
+  };
+
+  // A triangle clipped by four planes has at most seven corners.
+  using FClipPolygon = TArray<FClipVertex, TInlineAllocator<8>>;
+
+  bool IsLess(const FVector& A, const FVector& B)
+  {
+    return A.X != B.X ? A.X < B.X : (A.Y != B.Y ? A.Y < B.Y : A.Z < B.Z);
+  }
+
+  /** Where the edge AB crosses Axis = Value. */
+  FClipVertex Cut(const FClipVertex& InA, const FClipVertex& InB, int32 Axis, double Value)
+  {
+    // Always interpolate from the same end, so neighbouring triangles get
+    // bit-identical vertices on their shared edge.
+    const bool bSwap = IsLess(InB.Position, InA.Position);
+    const FClipVertex& A = bSwap ? InB : InA;
+    const FClipVertex& B = bSwap ? InA : InB;
+    const double T = (Value - A.Position[Axis]) / (B.Position[Axis] - A.Position[Axis]);
+    const float Alpha = (float)T;
+
+    FClipVertex Result;
+    Result.Position = FMath::Lerp(A.Position, B.Position, T);
+    Result.Position[Axis] = Value;
+    Result.Normal = FMath::Lerp(A.Normal, B.Normal, T).GetSafeNormal();
+    Result.UV = FMath::Lerp(A.UV, B.UV, T);
+    Result.Color = FMath::Lerp(A.Color, B.Color, Alpha);
+    Result.Tangent.TangentX = FMath::Lerp(A.Tangent.TangentX, B.Tangent.TangentX, T).GetSafeNormal();
+    Result.Tangent.bFlipTangentY = A.Tangent.bFlipTangentY;
+    return Result;
+  }
+
+  /** Keeps the part of Polygon where Sign * (Position[Axis] - Value) >= 0. */
+  void ClipPolygon(FClipPolygon& Polygon, int32 Axis, double Value, double Sign)
+  {
+    FClipPolygon Result;
+    for (int32 Index = 0; Index < Polygon.Num(); ++Index)
+    {
+      const FClipVertex& A = Polygon[Index];
+      const FClipVertex& B = Polygon[(Index + 1) % Polygon.Num()];
+      const bool bInsideA = Sign * (A.Position[Axis] - Value) >= 0.0;
+      const bool bInsideB = Sign * (B.Position[Axis] - Value) >= 0.0;
+      if (bInsideA)
+      {
+        Result.Add(A);
+      }
+      if (bInsideA != bInsideB)
+      {
+        Result.Add(Cut(A, B, Axis, Value));
+      }
+    }
+    Polygon = MoveTemp(Result);
+  }
+
+  class FChunkBuilder
+  {
+  public:
+
+    FChunkBuilder(
+      FProceduralMeshChunk& InChunk,
+      const FProceduralCustomMesh& InData,
+      const TArray<FProcMeshTangent>& InTangents)
+      : Chunk(InChunk),
+        Data(InData),
+        Tangents(InTangents),
+        bHasNormals(InData.Normals.Num() == InData.Vertices.Num()),
+        bHasUVs(InData.UV0.Num() == InData.Vertices.Num()),
+        bHasColors(InData.VertexColor.Num() == InData.Vertices.Num()),
+        bHasTangents(InTangents.Num() == InData.Vertices.Num())
+    {
+    }
+
+    FClipVertex GetInputVertex(int32 VertexIndex) const
+    {
+      FClipVertex Vertex;
+      Vertex.Position = Data.Vertices[VertexIndex];
+      Vertex.Normal = bHasNormals ? Data.Normals[VertexIndex] : FVector::ZeroVector;
+      Vertex.UV = bHasUVs ? Data.UV0[VertexIndex] : FVector2D::ZeroVector;
+      Vertex.Color = bHasColors ? Data.VertexColor[VertexIndex] : FLinearColor::Black;
+      Vertex.Tangent = bHasTangents ? Tangents[VertexIndex] : FProcMeshTangent();
+      Vertex.Source = VertexIndex;
+      return Vertex;
+    }
+
+    void AddTriangle(const FClipVertex& A, const FClipVertex& B, const FClipVertex& C)
+    {
+      // Clipping a triangle that touches a border leaves slivers without area.
+      const FVector Cross = (B.Position - A.Position) ^ (C.Position - A.Position);
+      if (Cross.SizeSquared() <= UE_SMALL_NUMBER)
+      {
+        return;
+      }
+      Chunk.Mesh.Triangles.Add(AddVertex(A));
+      Chunk.Mesh.Triangles.Add(AddVertex(B));
+      Chunk.Mesh.Triangles.Add(AddVertex(C));
+    }
+
+  private:
+
+    int32 AddVertex(const FClipVertex& Vertex)
+    {
+      // Input vertices stay shared between the triangles that use them. Cut
+      // vertices are not shared, welding can merge them later.
+      if (Vertex.Source != INDEX_NONE)
+      {
+        if (const int32* Existing = InputVertices.Find(Vertex.Source))
+        {
+          return *Existing;
+        }
+      }
+
+      const int32 Index = Chunk.Mesh.Vertices.Add(Vertex.Position - Chunk.Origin);
+      if (bHasNormals)
+      {
+        Chunk.Mesh.Normals.Add(Vertex.Normal);
+      }
+      if (bHasUVs)
+      {
+        Chunk.Mesh.UV0.Add(Vertex.UV);
+      }
+      if (bHasColors)
+      {
+        Chunk.Mesh.VertexColor.Add(Vertex.Color);
+      }
+      if (bHasTangents)
+      {
+        Chunk.Tangents.Add(Vertex.Tangent);
+      }
+      if (Vertex.Source != INDEX_NONE)
+      {
+        InputVertices.Add(Vertex.Source, Index);
+      }
+      return Index;
+    }
+
+    FProceduralMeshChunk& Chunk;
+    const FProceduralCustomMesh& Data;
+    const TArray<FProcMeshTangent>& Tangents;
+    const bool bHasNormals;
+    const bool bHasUVs;
+    const bool bHasColors;
+    const bool bHasTangents;
+    TMap<int32, int32> InputVertices;
+  };
+}
+
+FIntPoint FProceduralMeshChunking::GetCell(const FVector& Position, float CellSize)
+{
+  return FIntPoint(
+    FMath::FloorToInt(Position.X / CellSize),
+    FMath::FloorToInt(Position.Y / CellSize));
+}
+
+FVector FProceduralMeshChunking::GetCellOrigin(const FIntPoint& Cell, float CellSize)
+{
+  return FVector((Cell.X + 0.5) * CellSize, (Cell.Y + 0.5) * CellSize, 0.0);
+}
+
+TArray<FProceduralMeshChunk> FProceduralMeshChunking::Split(
+  const FProceduralCustomMesh& Data,
+  const TArray<FProcMeshTangent>& Tangents,
+  float CellSize)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralMeshChunking::Split);
+
+  TArray<FProceduralMeshChunk> Chunks;
+  if (CellSize <= 0.0f)
+  {
+    return Chunks;
+  }
+
+  const int32 NumTriangles = Data.Triangles.Num() / 3;
+  if (Data.Triangles.Num() % 3 != 0)
+  {
+    UE_LOG(LogCarlaMeshGeneration, Warning, TEXT("Ignoring %d trailing indices that do not form a triangle"),
+      Data.Triangles.Num() % 3);
+  }
+  for (int32 IndiceIndex = 0; IndiceIndex < NumTriangles * 3; ++IndiceIndex)
+  {
+    if ((uint32)Data.Triangles[IndiceIndex] >= (uint32)Data.Vertices.Num())
+    {
+      UE_LOG(LogCarlaMeshGeneration, Error, TEXT("Triangle index %d refers to missing vertex %d"),
+        IndiceIndex, Data.Triangles[IndiceIndex]);
+      return Chunks;
+    }
+  }
+
+  // Bucket the triangles by the cells their bounds overlap. A triangle whose
+  // bounds end exactly on a border does not reach into the next cell.
+  TMap<FIntPoint, TArray<int32>> CellTriangles;
+  for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
+  {
+    FBox Bounds(ForceInit);
+    for (int32 Corner = 0; Corner < 3; ++Corner)
+    {
+      Bounds += Data.Vertices[Data.Triangles[TriangleIndex * 3 + Corner]];
+    }
+    const FIntPoint Min = GetCell(Bounds.Min, CellSize);
+    const FIntPoint Max(
+      FMath::Max(Min.X, FMath::CeilToInt(Bounds.Max.X / CellSize) - 1),
+      FMath::Max(Min.Y, FMath::CeilToInt(Bounds.Max.Y / CellSize) - 1));
+    for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+    {
+      for (int32 X = Min.X; X <= Max.X; ++X)
+      {
+        CellTriangles.FindOrAdd(FIntPoint(X, Y)).Add(TriangleIndex);
+      }
+    }
+  }
+
+  CellTriangles.KeySort([](const FIntPoint& A, const FIntPoint& B)
+    {
+      return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+    });
+  TArray<const TArray<int32>*> ChunkTriangles;
+  Chunks.Reserve(CellTriangles.Num());
+  ChunkTriangles.Reserve(CellTriangles.Num());
+  for (const TPair<FIntPoint, TArray<int32>>& Cell : CellTriangles)
+  {
+    FProceduralMeshChunk& Chunk = Chunks.AddDefaulted_GetRef();
+    Chunk.Cell = Cell.Key;
+    Chunk.Origin = GetCellOrigin(Cell.Key, CellSize);
+    ChunkTriangles.Add(&Cell.Value);
+  }
+
+  ParallelFor(Chunks.Num(), [&](int32 ChunkIndex)
+    {
+      FProceduralMeshChunk& Chunk = Chunks[ChunkIndex];
+      FChunkBuilder Builder(Chunk, Data, Tangents);
+      const double MinX = (double)Chunk.Cell.X * CellSize;
+      const double MinY = (double)Chunk.Cell.Y * CellSize;
+
+      for (int32 TriangleIndex : *ChunkTriangles[ChunkIndex])
+      {
+        FClipPolygon Polygon;
+        for (int32 Corner = 0; Corner < 3; ++Corner)
+        {
+          Polygon.Add(Builder.GetInputVertex(Data.Triangles[TriangleIndex * 3 + Corner]));
+        }
+
+        FBox Bounds(ForceInit);
+        for (const FClipVertex& Vertex : Polygon)
+        {
+          Bounds += Vertex.Position;
+        }
+        const double Min[2] = { MinX, MinY };
+        for (int32 Axis = 0; Axis < 2; ++Axis)
+        {
+          if (Bounds.Min[Axis] < Min[Axis])
+          {
+            ClipPolygon(Polygon, Axis, Min[Axis], 1.0);
+          }
+          if (Bounds.Max[Axis] > Min[Axis] + CellSize)
+          {
+            ClipPolygon(Polygon, Axis, Min[Axis] + CellSize, -1.0);
+          }
+        }
+
+        // The clipped polygon is convex, so a fan keeps the winding.
+        for (int32 Index = 2; Index < Polygon.Num(); ++Index)
+        {
+          Builder.AddTriangle(Polygon[0], Polygon[Index - 1], Polygon[Index]);
+        }
+      }
+    });
+
+  Chunks.RemoveAll([](const FProceduralMeshChunk& Chunk)
+    {
+      return Chunk.Mesh.Triangles.Num() == 0;
+    });
+  return Chunks;
+}
@@ -0,0 +1,298 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/ProceduralMeshCollision.h"
+
+#include "DynamicMesh/DynamicMesh3.h"
+#include "MeshSimplification.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "StaticMeshAttributes.h"
+
+namespace
+{
+  // Physics cannot build shapes without volume, e.g. around a flat road.
+  constexpr float MinThickness = 1.0f;
+
+  void GetTriangleSoup(
+    const FMeshDescription& Description,
+    TArray<FVector3f>& OutPositions,
+    TArray<FIntVector>& OutTriangles)
+  {
+    FStaticMeshConstAttributes Attributes(Description);
+    const auto VertexPositions = Attributes.GetVertexPositions();
+
+    OutPositions.SetNumZeroed(Description.Vertices().GetArraySize());
+    for (const FVertexID VertexID : Description.Vertices().GetElementIDs())
+    {
+      OutPositions[VertexID.GetValue()] = FVector3f(VertexPositions[VertexID]);
+    }
+
+    OutTriangles.Reset(Description.Triangles().Num());
+    for (const FTriangleID TriangleID : Description.Triangles().GetElementIDs())
+    {
+      const TArrayView<const FVertexID> Corners = Description.GetTriangleVertices(TriangleID);
+      OutTriangles.Emplace(Corners[0].GetValue(), Corners[1].GetValue(), Corners[2].GetValue());
+    }
+  }
+}
+
+void FProceduralMeshCollision::Build(
+  const FMeshDescription& Description,
+  const FProceduralMeshBuildSettings& BuildSettings,
+  FKAggregateGeom& OutSimple,
+  FMeshDescription& OutComplex)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralMeshCollision::Build);
+
+  if (BuildSettings.Collision != EProceduralMeshCollision::Boxes &&
+      BuildSettings.Collision != EProceduralMeshCollision::ConvexDecomposition &&
+      BuildSettings.Collision != EProceduralMeshCollision::SimplifiedComplex)
+  {
+    return;
+  }
+
+  TArray<FVector3f> Positions;
+  TArray<FIntVector> Triangles;
+  GetTriangleSoup(Description, Positions, Triangles);
+
+  switch (BuildSettings.Collision)
+  {
+  case EProceduralMeshCollision::Boxes:
+    BuildBoxes(Positions, Triangles, BuildSettings.CollisionCellSize, OutSimple);
+    break;
+  case EProceduralMeshCollision::ConvexDecomposition:
+    BuildConvexParts(Positions, Triangles, BuildSettings.MaxConvexHulls, OutSimple);
+    break;
+  case EProceduralMeshCollision::SimplifiedComplex:
+    OutComplex = BuildSimplifiedMesh(Positions, Triangles, BuildSettings.CollisionTriangleBudget);
+    break;
+  default:
+    break;
+  }
+}
+
+void FProceduralMeshCollision::BuildBoxes(
+  TConstArrayView<FVector3f> Positions,
+  TConstArrayView<FIntVector> Triangles,
+  float CellSize,
+  FKAggregateGeom& OutSimple)
+{
+  const float InvCellSize = 1.0f / FMath::Max(CellSize, 1.0f);
+  TMap<FIntPoint, FBox3f> Cells;
+  for (const FIntVector& Triangle : Triangles)
+  {
+    const FVector3f& A = Positions[Triangle.X];
+    const FVector3f& B = Positions[Triangle.Y];
+    const FVector3f& C = Positions[Triangle.Z];
+    const FVector3f Centroid = (A + B + C) / 3.0f;
+    const FIntPoint Cell(
+      FMath::FloorToInt(Centroid.X * InvCellSize),
+      FMath::FloorToInt(Centroid.Y * InvCellSize));
+
+    FBox3f& Bounds = Cells.FindOrAdd(Cell, FBox3f(ForceInit));
+    Bounds += A;
+    Bounds += B;
+    Bounds += C;
+  }
+
+  OutSimple.BoxElems.Reserve(OutSimple.BoxElems.Num() + Cells.Num());
+  for (const TPair<FIntPoint, FBox3f>& Cell : Cells)
+  {
+    const FVector3f Size = Cell.Value.GetSize().ComponentMax(FVector3f(MinThickness));
+    FKBoxElem& Box = OutSimple.BoxElems.Emplace_GetRef(Size.X, Size.Y, Size.Z);
+    Box.Center = FVector(Cell.Value.GetCenter());
+  }
+}
+
+void FProceduralMeshCollision::BuildConvexParts(
+  TConstArrayView<FVector3f> Positions,
+  TConstArrayView<FIntVector> Triangles,
+  int32 MaxHulls,
+  FKAggregateGeom& OutSimple)
+{
+  if (Triangles.Num() == 0)
+  {
+    return;
+  }
+
+  TArray<FVector3f> Centroids;
+  Centroids.SetNumUninitialized(Triangles.Num());
+  for (int32 TriangleIndex = 0; TriangleIndex < Triangles.Num(); ++TriangleIndex)
+  {
+    const FIntVector& Triangle = Triangles[TriangleIndex];
+    Centroids[TriangleIndex] = (Positions[Triangle.X] + Positions[Triangle.Y] + Positions[Triangle.Z]) / 3.0f;
+  }
+
+  struct FPart
+  {
+    TArray<int32> Triangles;
+    FBox3f Bounds = FBox3f(ForceInit);
+  };
+
+  auto MakePart = [&](TArray<int32>&& PartTriangles)
+  {
+    FPart Part;
+    Part.Triangles = MoveTemp(PartTriangles);
+    for (int32 TriangleIndex : Part.Triangles)
+    {
+      const FIntVector& Triangle = Triangles[TriangleIndex];
+      Part.Bounds += Positions[Triangle.X];
+      Part.Bounds += Positions[Triangle.Y];
+      Part.Bounds += Positions[Triangle.Z];
+    }
+    return Part;
+  };
+
+  TArray<int32> AllTriangles;
+  AllTriangles.SetNumUninitialized(Triangles.Num());
+  for (int32 TriangleIndex = 0; TriangleIndex < Triangles.Num(); ++TriangleIndex)
+  {
+    AllTriangles[TriangleIndex] = TriangleIndex;
+  }
+  TArray<FPart> Parts;
+  Parts.Add(MakePart(MoveTemp(AllTriangles)));
+
+  while (Parts.Num() < MaxHulls)
+  {
+    // Measured by the diagonal, so flat parts are split too.
+    int32 Largest = INDEX_NONE;
+    float LargestSize = 0.0f;
+    for (int32 PartIndex = 0; PartIndex < Parts.Num(); ++PartIndex)
+    {
+      const float Size = Parts[PartIndex].Bounds.GetSize().SizeSquared();
+      if (Parts[PartIndex].Triangles.Num() >= 2 && Size > LargestSize)
+      {
+        Largest = PartIndex;
+        LargestSize = Size;
+      }
+    }
+    if (Largest == INDEX_NONE)
+    {
+      break;
+    }
+
+    FPart Part = MoveTemp(Parts[Largest]);
+    Parts.RemoveAtSwap(Largest);
+
+    const FVector3f Size = Part.Bounds.GetSize();
+    const int32 Axis = Size.X >= Size.Y && Size.X >= Size.Z ? 0 : (Size.Y >= Size.Z ? 1 : 2);
+    Part.Triangles.Sort([&](int32 A, int32 B)
+      {
+        return Centroids[A][Axis] < Centroids[B][Axis];
+      });
+
+    const int32 Half = Part.Triangles.Num() / 2;
+    TArray<int32> Upper(Part.Triangles.GetData() + Half, Part.Triangles.Num() - Half);
+    Part.Triangles.SetNum(Half);
+    Parts.Add(MakePart(MoveTemp(Part.Triangles)));
+    Parts.Add(MakePart(MoveTemp(Upper)));
+  }
+
+  TArray<int32> LastPart;
+  LastPart.Init(INDEX_NONE, Positions.Num());
+  OutSimple.ConvexElems.Reserve(OutSimple.ConvexElems.Num() + Parts.Num());
+  for (int32 PartIndex = 0; PartIndex < Parts.Num(); ++PartIndex)
+  {
+    const FPart& Part = Parts[PartIndex];
+    FKConvexElem& Elem = OutSimple.ConvexElems.AddDefaulted_GetRef();
+    for (int32 TriangleIndex : Part.Triangles)
+    {
+      const FIntVector& Triangle = Triangles[TriangleIndex];
+      for (int32 Corner = 0; Corner < 3; ++Corner)
+      {
+        const int32 VertexIndex = Triangle[Corner];
+        if (LastPart[VertexIndex] != PartIndex)
+        {
+          LastPart[VertexIndex] = PartIndex;
+          Elem.VertexData.Add(FVector(Positions[VertexIndex]));
+        }
+      }
+    }
+
+    // Give planar parts, like a single wall, some thickness.
+    const FVector3f Size = Part.Bounds.GetSize();
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+      if (Size[Axis] < MinThickness)
+      {
+        FVector Offset = FVector::ZeroVector;
+        Offset[Axis] = MinThickness;
+        const int32 NumVertices = Elem.VertexData.Num();
+        for (int32 VertexIndex = 0; VertexIndex < NumVertices; ++VertexIndex)
+        {
+          Elem.VertexData.Add(Elem.VertexData[VertexIndex] + Offset);
+        }
+      }
+    }
+    Elem.UpdateElemBox();
+  }
+}
+
+FMeshDescription FProceduralMeshCollision::BuildSimplifiedMesh(
+  TConstArrayView<FVector3f> Positions,
+  TConstArrayView<FIntVector> Triangles,
+  int32 TriangleBudget)
+{
+  using namespace UE::Geometry;
+
+  // Render meshes split vertices along seams, which would keep the
+  // simplifier from collapsing across them.
+  FDynamicMesh3 Mesh;
+  TMap<FVector3f, int32> WeldedVertices;
+  WeldedVertices.Reserve(Positions.Num());
+  TArray<int32> VertexMap;
+  VertexMap.SetNumUninitialized(Positions.Num());
+  for (int32 VertexIndex = 0; VertexIndex < Positions.Num(); ++VertexIndex)
+  {
+    const FVector3f& Position = Positions[VertexIndex];
+    const int32* Existing = WeldedVertices.Find(Position);
+    VertexMap[VertexIndex] = Existing != nullptr ?
+      *Existing :
+      WeldedVertices.Add(Position, Mesh.AppendVertex(FVector3d(Position)));
+  }
+  for (const FIntVector& Triangle : Triangles)
+  {
+    // Degenerate and non-manifold triangles are rejected, which a collision
+    // proxy can do without.
+    Mesh.AppendTriangle(FIndex3i(VertexMap[Triangle.X], VertexMap[Triangle.Y], VertexMap[Triangle.Z]));
+  }
+
+  if (Mesh.TriangleCount() > TriangleBudget)
+  {
+    FQEMSimplification Simplifier(&Mesh);
+    Simplifier.SimplifyToTriangleCount(TriangleBudget);
+  }
+  Mesh.CompactInPlace();
+
+  FMeshDescription Description;
+  FStaticMeshAttributes Attributes(Description);
+  Attributes.Register();
+  auto VertexPositions = Attributes.GetVertexPositions();
+
+  Description.ReserveNewVertices(Mesh.VertexCount());
+  Description.ReserveNewVertexInstances(Mesh.TriangleCount() * 3);
+  Description.ReserveNewTriangles(Mesh.TriangleCount());
+  Description.ReserveNewPolygons(Mesh.TriangleCount());
+  Description.ReserveNewEdges(Mesh.TriangleCount() * 2);
+  const FPolygonGroupID PolygonGroup = Description.CreatePolygonGroup();
+
+  for (int32 VertexIndex = 0; VertexIndex < Mesh.VertexCount(); ++VertexIndex)
+  {
+    const FVertexID VertexID = Description.CreateVertex();
+    VertexPositions[VertexID] = FVector3f(Mesh.GetVertex(VertexIndex));
+  }
+  for (int32 TriangleIndex = 0; TriangleIndex < Mesh.TriangleCount(); ++TriangleIndex)
+  {
+    const FIndex3i Triangle = Mesh.GetTriangle(TriangleIndex);
+    const FVertexInstanceID VertexInstanceIDs[3] = {
+      Description.CreateVertexInstance(FVertexID(Triangle.A)),
+      Description.CreateVertexInstance(FVertexID(Triangle.B)),
+      Description.CreateVertexInstance(FVertexID(Triangle.C))
+    };
+    Description.CreateTriangle(PolygonGroup, VertexInstanceIDs);
+  }
+  return Description;
+}
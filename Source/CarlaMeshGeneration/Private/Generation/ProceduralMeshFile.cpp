@@ -0,0 +1,206 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/ProceduralMeshFile.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/PackageName.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DEFINE_LOG_CATEGORY(LogCarlaProceduralMeshFile);
+
+namespace
+{
+  struct FFileHeader
+  {
+    char Magic[4];
+    uint32 Version;
+    uint32 NumMeshes;
+    uint32 Reserved0;
+    uint64 TableOffset;
+    uint64 Reserved1;
+  };
+  static_assert(sizeof(FFileHeader) == 32, "The header layout is part of the file format");
+
+  struct FMeshEntry
+  {
+    uint64 NameOffset;
+    uint32 NameLength;
+    uint32 MaterialPathLength;
+    uint64 MaterialPathOffset;
+    uint32 NumVertices;
+    uint32 NumIndices;
+    uint64 PositionsOffset;
+    uint64 TrianglesOffset;
+    uint64 NormalsOffset;
+    uint64 TangentsOffset;
+    uint64 UV0Offset;
+    uint64 ColorsOffset;
+    uint64 Reserved[2];
+  };
+  static_assert(sizeof(FMeshEntry) == 96, "The mesh table layout is part of the file format");
+
+  constexpr uint64 BlockAlignment = 16;
+
+  /** Mesh names become asset and package names, so they must be valid as both. */
+  bool IsValidMeshName(const FString& Name)
+  {
+    const FString InvalidCharacters = FString(INVALID_OBJECTNAME_CHARACTERS) + INVALID_LONGPACKAGE_CHARACTERS;
+    return !Name.IsEmpty() && FName::IsValidXName(Name, InvalidCharacters);
+  }
+
+  /** Bounds checks blocks of the mapped file and views them in place. */
+  class FBlockReader
+  {
+  public:
+
+    FBlockReader(const uint8* InData, uint64 InSize, const FString& InFilename)
+      : Data(InData), Size(InSize), Filename(InFilename)
+    {
+    }
+
+    bool IsValid(uint64 Offset, uint64 Count, uint64 ElementSize, const TCHAR* What) const
+    {
+      const bool bFits = Count <= Size / ElementSize && Offset <= Size - Count * ElementSize;
+      if (!bFits || Offset % BlockAlignment != 0)
+      {
+        UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s: %s at offset %llu is misaligned or past the end of the file"),
+          *Filename, What, Offset);
+        return false;
+      }
+      return true;
+    }
+
+    /** A block that may be absent, marked by a zero offset. */
+    template <typename T>
+    bool View(uint64 Offset, uint32 Count, const TCHAR* What, TConstArrayView<T>& OutView) const
+    {
+      if (Offset == 0)
+      {
+        OutView = TConstArrayView<T>();
+        return true;
+      }
+      if (!IsValid(Offset, Count, sizeof(T), What))
+      {
+        return false;
+      }
+      OutView = TConstArrayView<T>(reinterpret_cast<const T*>(Data + Offset), (int32)Count);
+      return true;
+    }
+
+    bool String(uint64 Offset, uint32 Length, const TCHAR* What, FString& OutString) const
+    {
+      // Strings are packed without padding, so only their bounds are checked.
+      if (Length > Size || Offset > Size - Length)
+      {
+        UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s: %s at offset %llu is past the end of the file"),
+          *Filename, What, Offset);
+        return false;
+      }
+      const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data + Offset), Length);
+      OutString = FString(Converted.Length(), Converted.Get());
+      return true;
+    }
+
+  private:
+
+    const uint8* Data;
+    uint64 Size;
+    const FString& Filename;
+  };
+}
+
+FProceduralMeshFile::~FProceduralMeshFile()
+{
+  // The region has to be unmapped before its file is closed.
+  Region.Reset();
+  Handle.Reset();
+}
+
+TUniquePtr<FProceduralMeshFile> FProceduralMeshFile::Open(const FString& Filename)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralMeshFile::Open);
+
+  TUniquePtr<FProceduralMeshFile> File(new FProceduralMeshFile());
+  FOpenMappedResult Mapped = FPlatformFileManager::Get().GetPlatformFile().OpenMappedEx(*Filename);
+  if (Mapped.HasError())
+  {
+    UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("Could not open %s"), *Filename);
+    return nullptr;
+  }
+  File->Handle = Mapped.StealValue();
+
+  const int64 FileSize = File->Handle->GetFileSize();
+  if (FileSize < (int64)sizeof(FFileHeader))
+  {
+    UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s is too small to be a mesh file"), *Filename);
+    return nullptr;
+  }
+  File->Region.Reset(File->Handle->MapRegion(0, FileSize));
+  if (!File->Region.IsValid())
+  {
+    UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("Could not map %s"), *Filename);
+    return nullptr;
+  }
+
+  // The mapping is page aligned, so the header and the 16-byte aligned
+  // blocks can be read in place.
+  const uint8* Data = File->Region->GetMappedPtr();
+  const FFileHeader& Header = *reinterpret_cast<const FFileHeader*>(Data);
+  if (FMemory::Memcmp(Header.Magic, "CMGM", 4) != 0 || Header.Version != Version)
+  {
+    UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s is not a version %u mesh file"), *Filename, Version);
+    return nullptr;
+  }
+
+  const FBlockReader Blocks(Data, (uint64)FileSize, Filename);
+  if (!Blocks.IsValid(Header.TableOffset, Header.NumMeshes, sizeof(FMeshEntry), TEXT("Mesh table")))
+  {
+    return nullptr;
+  }
+  const FMeshEntry* Entries = reinterpret_cast<const FMeshEntry*>(Data + Header.TableOffset);
+
+  File->Meshes.SetNum(Header.NumMeshes);
+  for (uint32 Index = 0; Index < Header.NumMeshes; ++Index)
+  {
+    const FMeshEntry& Entry = Entries[Index];
+    FMesh& Mesh = File->Meshes[Index];
+    FProceduralCompactMeshView& View = Mesh.View;
+    const bool bValid =
+      Entry.NumVertices <= (uint32)MAX_int32 &&
+      Entry.NumIndices <= (uint32)MAX_int32 &&
+      Entry.PositionsOffset != 0 &&
+      Blocks.String(Entry.NameOffset, Entry.NameLength, TEXT("Name"), Mesh.Name) &&
+      Blocks.String(Entry.MaterialPathOffset, Entry.MaterialPathLength, TEXT("Material path"), Mesh.MaterialPath) &&
+      Blocks.View(Entry.PositionsOffset, Entry.NumVertices, TEXT("Positions"), View.Positions) &&
+      Blocks.View(Entry.TrianglesOffset, Entry.NumIndices, TEXT("Triangles"), View.Triangles) &&
+      Blocks.View(Entry.NormalsOffset, Entry.NumVertices, TEXT("Normals"), View.Normals) &&
+      Blocks.View(Entry.TangentsOffset, Entry.NumVertices, TEXT("Tangents"), View.Tangents) &&
+      Blocks.View(Entry.UV0Offset, Entry.NumVertices, TEXT("UV0"), View.UV0) &&
+      Blocks.View(Entry.ColorsOffset, Entry.NumVertices, TEXT("Colors"), View.Colors);
+    if (!bValid)
+    {
+      UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s: mesh %u is invalid"), *Filename, Index);
+      return nullptr;
+    }
+    if (!IsValidMeshName(Mesh.Name))
+    {
+      UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s: mesh %u has the invalid name \"%s\""),
+        *Filename, Index, *Mesh.Name);
+      return nullptr;
+    }
+    if (!Mesh.MaterialPath.IsEmpty() && !FPackageName::IsValidObjectPath(Mesh.MaterialPath))
+    {
+      UE_LOG(LogCarlaProceduralMeshFile, Error, TEXT("%s: mesh %s has the invalid material path \"%s\""),
+        *Filename, *Mesh.Name, *Mesh.MaterialPath);
+      return nullptr;
+    }
+  }
+
+  UE_LOG(LogCarlaProceduralMeshFile, Log, TEXT("Mapped %u meshes from %s"), Header.NumMeshes, *Filename);
+  return File;
+}
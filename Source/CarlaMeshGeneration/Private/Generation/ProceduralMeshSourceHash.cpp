@@ -0,0 +1,38 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/ProceduralMeshSourceHash.h"
+
+#include "Engine/StaticMesh.h"
+#include "Misc/PackageName.h"
+
+UStaticMesh* UProceduralMeshSourceHash::FindUnchangedMesh(const FString& PackageName, FName MeshName, uint64 Hash)
+{
+  const FString ObjectPath = PackageName + TEXT(".") + MeshName.ToString();
+  UStaticMesh* Mesh = FindObject<UStaticMesh>(nullptr, *ObjectPath);
+  if (Mesh == nullptr && FPackageName::DoesPackageExist(PackageName))
+  {
+    Mesh = LoadObject<UStaticMesh>(nullptr, *ObjectPath, nullptr, LOAD_NoWarn | LOAD_Quiet);
+  }
+  if (Mesh == nullptr)
+  {
+    return nullptr;
+  }
+
+  const UProceduralMeshSourceHash* SourceHash = Mesh->GetAssetUserData<UProceduralMeshSourceHash>();
+  return SourceHash != nullptr && SourceHash->Hash == Hash ? Mesh : nullptr;
+}
+
+void UProceduralMeshSourceHash::SetHash(UStaticMesh* Mesh, uint64 Hash)
+{
+  UProceduralMeshSourceHash* SourceHash = Mesh->GetAssetUserData<UProceduralMeshSourceHash>();
+  if (SourceHash == nullptr)
+  {
+    SourceHash = NewObject<UProceduralMeshSourceHash>(Mesh, NAME_None, RF_Transactional);
+    Mesh->AddAssetUserData(SourceHash);
+  }
+  SourceHash->Hash = Hash;
+}
@@ -0,0 +1,324 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/SpatialIndex2D.h"
+
+#include "Async/ParallelFor.h"
+
+#include <algorithm>
+
+static constexpr int32 MaxPolygonSlabs = 4096;
+static constexpr int32 ClassifyChunkSize = 1024;
+
+FPolygonIndex2D::FPolygonIndex2D(TConstArrayView<FVector2f> InVertices)
+{
+  Build(InVertices);
+}
+
+void FPolygonIndex2D::Build(TConstArrayView<FVector2f> InVertices)
+{
+  Vertices.Reset(InVertices.Num());
+  Vertices.Append(InVertices.GetData(), InVertices.Num());
+
+  Bounds = FBox2f(ForceInit);
+  for (const FVector2f& Vertex : Vertices)
+    Bounds += Vertex;
+
+  SlabOffsets.Reset();
+  EdgeX0.Reset();
+  EdgeY0.Reset();
+  EdgeY1.Reset();
+  EdgeSlope.Reset();
+  EdgeDirection.Reset();
+  NumSlabs = 0;
+  InvSlabHeight = 0.0f;
+
+  const int32 NumVertices = Vertices.Num();
+  if (NumVertices < 3)
+    return;
+
+  // About one edge per slab on average keeps queries near constant time.
+  NumSlabs = FMath::Clamp(NumVertices, 1, MaxPolygonSlabs);
+  const float Height = Bounds.Max.Y - Bounds.Min.Y;
+  InvSlabHeight = Height > 0.0f ? (float)NumSlabs / Height : 0.0f;
+
+  auto ForEachEdge = [&](auto&& Function)
+    {
+      for (int32 i = 0; i < NumVertices; ++i)
+      {
+        const FVector2f& A = Vertices[i];
+        const FVector2f& B = Vertices[(i + 1) % NumVertices];
+        // Horizontal edges never cross a horizontal ray.
+        if (A.Y == B.Y)
+          continue;
+        Function(A, B, GetSlab(FMath::Min(A.Y, B.Y)), GetSlab(FMath::Max(A.Y, B.Y)));
+      }
+    };
+
+  SlabOffsets.SetNumZeroed(NumSlabs + 1);
+  ForEachEdge([&](const FVector2f&, const FVector2f&, int32 FirstSlab, int32 LastSlab)
+    {
+      for (int32 Slab = FirstSlab; Slab <= LastSlab; ++Slab)
+        ++SlabOffsets[Slab + 1];
+    });
+
+  for (int32 Slab = 0; Slab < NumSlabs; ++Slab)
+    SlabOffsets[Slab + 1] += SlabOffsets[Slab];
+
+  const int32 NumEntries = SlabOffsets[NumSlabs];
+  EdgeX0.SetNumUninitialized(NumEntries);
+  EdgeY0.SetNumUninitialized(NumEntries);
+  EdgeY1.SetNumUninitialized(NumEntries);
+  EdgeSlope.SetNumUninitialized(NumEntries);
+  EdgeDirection.SetNumUninitialized(NumEntries);
+
+  TArray<int32> Cursor(SlabOffsets.GetData(), NumSlabs);
+  ForEachEdge([&](const FVector2f& A, const FVector2f& B, int32 FirstSlab, int32 LastSlab)
+    {
+      const bool bUpward = B.Y > A.Y;
+      const FVector2f& Lower = bUpward ? A : B;
+      const FVector2f& Upper = bUpward ? B : A;
+      for (int32 Slab = FirstSlab; Slab <= LastSlab; ++Slab)
+      {
+        const int32 Entry = Cursor[Slab]++;
+        EdgeX0[Entry] = Lower.X;
+        EdgeY0[Entry] = Lower.Y;
+        EdgeY1[Entry] = Upper.Y;
+        EdgeSlope[Entry] = (Upper.X - Lower.X) / (Upper.Y - Lower.Y);
+        EdgeDirection[Entry] = bUpward ? 1 : -1;
+      }
+    });
+}
+
+int32 FPolygonIndex2D::GetSlab(float Y) const
+{
+  return FMath::Clamp((int32)((Y - Bounds.Min.Y) * InvSlabHeight), 0, NumSlabs - 1);
+}
+
+int32 FPolygonIndex2D::GetWindingNumber(const FVector2f& Point) const
+{
+  if (NumSlabs == 0 ||
+      Point.X < Bounds.Min.X || Point.X > Bounds.Max.X ||
+      Point.Y < Bounds.Min.Y || Point.Y >= Bounds.Max.Y)
+    return 0;
+
+  const int32 Slab = GetSlab(Point.Y);
+  const int32 Begin = SlabOffsets[Slab];
+  const int32 End = SlabOffsets[Slab + 1];
+  const float* X0 = EdgeX0.GetData();
+  const float* Y0 = EdgeY0.GetData();
+  const float* Y1 = EdgeY1.GetData();
+  const float* Slope = EdgeSlope.GetData();
+  const int32* Direction = EdgeDirection.GetData();
+
+  // Count signed crossings of the ray towards +X. Edges are half-open in Y so
+  // a ray through a shared vertex counts exactly once.
+  int32 Winding = 0;
+  for (int32 i = Begin; i < End; ++i)
+  {
+    const float DY = Point.Y - Y0[i];
+    const bool bSpans = (DY >= 0.0f) & (Point.Y < Y1[i]);
+    const bool bRight = X0[i] + DY * Slope[i] > Point.X;
+    Winding += (bSpans & bRight) ? Direction[i] : 0;
+  }
+  return Winding;
+}
+
+void FPolygonIndex2D::ClassifyPoints(TConstArrayView<FVector2f> Points, TArrayView<bool> OutInside) const
+{
+  check(Points.Num() == OutInside.Num());
+
+  const int32 NumChunks = FMath::DivideAndRoundUp(Points.Num(), ClassifyChunkSize);
+  ParallelFor(NumChunks, [&](int32 Chunk)
+    {
+      const int32 Begin = Chunk * ClassifyChunkSize;
+      const int32 End = FMath::Min(Begin + ClassifyChunkSize, Points.Num());
+      for (int32 i = Begin; i < End; ++i)
+        OutInside[i] = IsInside(Points[i]);
+    });
+}
+
+void FPolygonIndex2D::GetCrossings(float Y, TArray<TPair<float, int32>>& OutCrossings) const
+{
+  if (NumSlabs == 0 || Y < Bounds.Min.Y || Y >= Bounds.Max.Y)
+    return;
+
+  const int32 Slab = GetSlab(Y);
+  for (int32 i = SlabOffsets[Slab]; i < SlabOffsets[Slab + 1]; ++i)
+  {
+    const float DY = Y - EdgeY0[i];
+    if (DY >= 0.0f && Y < EdgeY1[i])
+      OutCrossings.Emplace(EdgeX0[i] + DY * EdgeSlope[i], EdgeDirection[i]);
+  }
+}
+
+// Segments per leaf of the segment hierarchy.
+static constexpr int32 MaxLeafSegments = 4;
+
+// Deeper than any hierarchy split at the median can get.
+static constexpr int32 MaxTraversalStack = 64;
+
+FSegmentIndex2D::FSegmentIndex2D(TConstArrayView<FVector3f> InVertices, bool bInClosed)
+{
+  Build(InVertices, bInClosed);
+}
+
+void FSegmentIndex2D::Build(TConstArrayView<FVector3f> InVertices, bool bInClosed)
+{
+  Vertices.Reset(InVertices.Num() + 1);
+  Vertices.Append(InVertices.GetData(), InVertices.Num());
+  if (bInClosed && Vertices.Num() > 2)
+    Vertices.Add(Vertices[0]);
+
+  NumSegments = FMath::Max(Vertices.Num() - 1, 0);
+  Nodes.Reset();
+  SegmentOrder.Reset();
+  if (NumSegments == 0)
+    return;
+
+  TArray<FVector2f> Centers;
+  Centers.SetNumUninitialized(NumSegments);
+  SegmentOrder.SetNumUninitialized(NumSegments);
+  for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+  {
+    const FVector3f Center = (Vertices[Segment] + Vertices[Segment + 1]) * 0.5f;
+    Centers[Segment] = FVector2f(Center.X, Center.Y);
+    SegmentOrder[Segment] = Segment;
+  }
+
+  // Leaves are at least half full, which bounds the node count.
+  Nodes.Reserve(2 * FMath::DivideAndRoundUp(NumSegments, MaxLeafSegments / 2));
+  Nodes.AddUninitialized();
+  BuildNode(0, 0, NumSegments, Centers);
+}
+
+void FSegmentIndex2D::BuildNode(int32 NodeIndex, int32 Begin, int32 End, TConstArrayView<FVector2f> Centers)
+{
+  FBox2f Bounds(ForceInit);
+  FBox2f CenterBounds(ForceInit);
+  for (int32 i = Begin; i < End; ++i)
+  {
+    const int32 Segment = SegmentOrder[i];
+    Bounds += FVector2f(Vertices[Segment].X, Vertices[Segment].Y);
+    Bounds += FVector2f(Vertices[Segment + 1].X, Vertices[Segment + 1].Y);
+    CenterBounds += Centers[Segment];
+  }
+
+  Nodes[NodeIndex] = FNode{ Bounds.Min, Bounds.Max, Begin, End - Begin };
+  if (End - Begin <= MaxLeafSegments)
+    return;
+
+  // Split at the median center along the wider axis, so both halves hold
+  // the same number of segments and the depth stays logarithmic.
+  const FVector2f Extent = CenterBounds.Max - CenterBounds.Min;
+  const int32 Axis = Extent.X >= Extent.Y ? 0 : 1;
+  const int32 Middle = Begin + (End - Begin) / 2;
+  std::nth_element(
+    SegmentOrder.GetData() + Begin, SegmentOrder.GetData() + Middle, SegmentOrder.GetData() + End,
+    [&](int32 A, int32 B) { return Centers[A][Axis] < Centers[B][Axis]; });
+
+  // Children are allocated as a pair, so the second is found from the first.
+  const int32 FirstChild = Nodes.AddUninitialized(2);
+  Nodes[NodeIndex].First = FirstChild;
+  Nodes[NodeIndex].Count = 0;
+  BuildNode(FirstChild, Begin, Middle, Centers);
+  BuildNode(FirstChild + 1, Middle, End, Centers);
+}
+
+bool FSegmentIndex2D::FindNearest(const FVector2f& Point, int32& OutSegment, float& OutAlpha) const
+{
+  if (NumSegments == 0)
+    return false;
+
+  float BestDistSquared = TNumericLimits<float>::Max();
+  int32 BestSegment = 0;
+  float BestAlpha = 0.0f;
+
+  auto GetBoxDistSquared = [&Point](const FNode& Node)
+    {
+      const FVector2f Outside = FVector2f::Max(
+        FVector2f::Max(Node.Min - Point, Point - Node.Max), FVector2f::ZeroVector);
+      return Outside.SizeSquared();
+    };
+
+  int32 Stack[MaxTraversalStack];
+  int32 StackSize = 0;
+  Stack[StackSize++] = 0;
+  while (StackSize > 0)
+  {
+    const FNode& Node = Nodes[Stack[--StackSize]];
+    if (GetBoxDistSquared(Node) >= BestDistSquared)
+      continue;
+
+    if (Node.Count == 0)
+    {
+      // The nearer child goes on top so it is searched first, and tightens
+      // the bound before its sibling is checked against it.
+      const float FirstDistSquared = GetBoxDistSquared(Nodes[Node.First]);
+      const float SecondDistSquared = GetBoxDistSquared(Nodes[Node.First + 1]);
+      const bool bFirstIsNearer = FirstDistSquared <= SecondDistSquared;
+      check(StackSize + 2 <= MaxTraversalStack);
+      Stack[StackSize++] = bFirstIsNearer ? Node.First + 1 : Node.First;
+      Stack[StackSize++] = bFirstIsNearer ? Node.First : Node.First + 1;
+      continue;
+    }
+
+    for (int32 i = Node.First; i < Node.First + Node.Count; ++i)
+    {
+      const int32 Segment = SegmentOrder[i];
+      const FVector2f A(Vertices[Segment].X, Vertices[Segment].Y);
+      const FVector2f AB = FVector2f(Vertices[Segment + 1].X, Vertices[Segment + 1].Y) - A;
+      const float LengthSquared = AB.SizeSquared();
+      const float Alpha = LengthSquared > 0.0f ?
+        FMath::Clamp(FVector2f::DotProduct(Point - A, AB) / LengthSquared, 0.0f, 1.0f) :
+        0.0f;
+      const float DistSquared = FVector2f::DistSquared(A + AB * Alpha, Point);
+      if (DistSquared < BestDistSquared)
+      {
+        BestDistSquared = DistSquared;
+        BestSegment = Segment;
+        BestAlpha = Alpha;
+      }
+    }
+  }
+
+  OutSegment = BestSegment;
+  OutAlpha = BestAlpha;
+  return true;
+}
+
+float FSegmentIndex2D::GetZ(const FVector2f& Point) const
+{
+  int32 Segment;
+  float Alpha;
+  if (!FindNearest(Point, Segment, Alpha))
+    return 0.0f;
+  return FMath::Lerp(Vertices[Segment].Z, Vertices[Segment + 1].Z, Alpha);
+}
+
+float FSegmentIndex2D::GetDistanceSquared(const FVector2f& Point) const
+{
+  int32 Segment;
+  float Alpha;
+  if (!FindNearest(Point, Segment, Alpha))
+    return TNumericLimits<float>::Max();
+  const FVector3f Nearest = FMath::Lerp(Vertices[Segment], Vertices[Segment + 1], Alpha);
+  return FVector2f::DistSquared(FVector2f(Nearest.X, Nearest.Y), Point);
+}
+
+void FSegmentIndex2D::GetZ(TConstArrayView<FVector2f> Points, TArrayView<float> OutZ) const
+{
+  check(Points.Num() == OutZ.Num());
+
+  const int32 NumChunks = FMath::DivideAndRoundUp(Points.Num(), ClassifyChunkSize);
+  ParallelFor(NumChunks, [&](int32 Chunk)
+    {
+      const int32 Begin = Chunk * ClassifyChunkSize;
+      const int32 End = FMath::Min(Begin + ClassifyChunkSize, Points.Num());
+      for (int32 i = Begin; i < End; ++i)
+        OutZ[i] = GetZ(Points[i]);
+    });
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/ProceduralMeshFile.h"
+
+#include "Engine/Engine.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+  FString ToPythonList(TConstArrayView<FVector3f> Values)
+  {
+    TArray<FString> Items;
+    for (const FVector3f& Value : Values)
+    {
+      Items.Add(FString::Printf(TEXT("[%.9g, %.9g, %.9g]"), Value.X, Value.Y, Value.Z));
+    }
+    return TEXT("[") + FString::Join(Items, TEXT(", ")) + TEXT("]");
+  }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FProceduralMeshFileRoundTripTest,
+  "CarlaMeshGeneration.MeshFile.PythonRoundTrip",
+  EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FProceduralMeshFileRoundTripTest::RunTest(const FString& Parameters)
+{
+  // Python is optional for the plugin, so the writer is run through the
+  // console command of the Python plugin, when it is loaded.
+  if (!FModuleManager::Get().IsModuleLoaded(TEXT("PythonScriptPlugin")))
+  {
+    AddWarning(TEXT("Python is not available, skipping the mesh file round trip"));
+    return true;
+  }
+
+  // Every optional channel is written. The normals and tangents cover both
+  // hemispheres, so the octahedral fold is exercised, and the UVs are exact
+  // in half precision.
+  const TArray<FVector3f> Positions = {
+    FVector3f(0.0f, 0.0f, 0.0f), FVector3f(100.0f, 0.0f, 0.0f),
+    FVector3f(0.0f, 100.0f, 0.0f), FVector3f(100.0f, 100.0f, 50.0f) };
+  const TArray<int32> Triangles = { 0, 2, 1, 1, 2, 3 };
+  const TArray<FVector3f> Normals = {
+    FVector3f(0.0f, 0.0f, 1.0f), FVector3f(0.0f, 0.0f, -1.0f),
+    FVector3f(0.6f, 0.0f, 0.8f), FVector3f(-1.0f, -2.0f, -3.0f).GetSafeNormal() };
+  const TArray<FVector3f> Tangents = {
+    FVector3f(1.0f, 0.0f, 0.0f), FVector3f(0.0f, 1.0f, 0.0f),
+    FVector3f(0.0f, 0.0f, -1.0f), FVector3f(0.6f, -0.8f, 0.0f) };
+  const TArray<bool> FlipTangentY = { false, true, false, true };
+  const TArray<FVector2f> UV0 = {
+    FVector2f(0.0f, 0.0f), FVector2f(1.0f, 0.0f), FVector2f(0.5f, 0.25f), FVector2f(-2.0f, 3.5f) };
+  const TArray<FColor> Colors = {
+    FColor(255, 0, 0, 255), FColor(0, 128, 255, 64), FColor(1, 2, 3, 4), FColor(250, 251, 252, 0) };
+
+  TArray<FString> TriangleItems, FlipItems, UVItems, ColorItems;
+  for (int32 Index : Triangles)
+  {
+    TriangleItems.Add(FString::FromInt(Index));
+  }
+  for (int32 Index = 0; Index < Positions.Num(); ++Index)
+  {
+    FlipItems.Add(FlipTangentY[Index] ? TEXT("True") : TEXT("False"));
+    UVItems.Add(FString::Printf(TEXT("[%.9g, %.9g]"), UV0[Index].X, UV0[Index].Y));
+    ColorItems.Add(FString::Printf(TEXT("[%d, %d, %d, %d]"), Colors[Index].R, Colors[Index].G, Colors[Index].B, Colors[Index].A));
+  }
+
+  const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir());
+  const FString Filename = Directory / TEXT("carla_mesh_file_round_trip.cmgm");
+  const FString ScriptFilename = Directory / TEXT("carla_mesh_file_round_trip.py");
+  const FString NoNumpyFilename = Directory / TEXT("carla_mesh_file_round_trip.no_numpy");
+  IFileManager::Get().MakeDirectory(*Directory, true);
+  IFileManager::Get().Delete(*Filename);
+  IFileManager::Get().Delete(*NoNumpyFilename);
+
+  const FString Script = FString::Printf(TEXT(
+    "import importlib.util\n"
+    "if importlib.util.find_spec('numpy') is None:\n"
+    "    open(r'%s', 'w').close()\n"
+    "else:\n"
+    "    import carla_mesh_file\n"
+    "    with carla_mesh_file.MeshFileWriter(r'%s') as writer:\n"
+    "        writer.add_mesh('RoundTrip', %s, [%s], normals=%s, tangents=%s, flip_tangent_y=[%s], uv0=[%s], colors=[%s])\n"),
+    *NoNumpyFilename,
+    *Filename,
+    *ToPythonList(Positions),
+    *FString::Join(TriangleItems, TEXT(", ")),
+    *ToPythonList(Normals),
+    *ToPythonList(Tangents),
+    *FString::Join(FlipItems, TEXT(", ")),
+    *FString::Join(UVItems, TEXT(", ")),
+    *FString::Join(ColorItems, TEXT(", ")));
+  if (!TestTrue(TEXT("Script written"), FFileHelper::SaveStringToFile(Script, *ScriptFilename)) ||
+    !TestTrue(TEXT("Python command ran"), GEngine->Exec(nullptr, *FString::Printf(TEXT("py \"%s\""), *ScriptFilename))))
+  {
+    return false;
+  }
+  if (IFileManager::Get().FileExists(*NoNumpyFilename))
+  {
+    AddWarning(TEXT("numpy is not installed in the editor's Python, skipping the mesh file round trip"));
+    return true;
+  }
+
+  {
+    const TUniquePtr<FProceduralMeshFile> File = FProceduralMeshFile::Open(Filename);
+    if (!TestTrue(TEXT("File opens"), File.IsValid()) ||
+      !TestEqual(TEXT("Mesh count"), File->NumMeshes(), 1))
+    {
+      return false;
+    }
+    TestEqual(TEXT("Name"), File->GetMeshName(0), FString(TEXT("RoundTrip")));
+    TestTrue(TEXT("No material path"), File->GetMaterialPath(0).IsEmpty());
+
+    const FProceduralCompactMeshView& View = File->GetMesh(0);
+    if (!TestEqual(TEXT("Vertex count"), View.NumVertices(), Positions.Num()) ||
+      !TestTrue(TEXT("Every channel is present"), View.HasNormals() && View.HasTangents() && View.HasUV0() && View.HasColors()))
+    {
+      return false;
+    }
+    TestTrue(TEXT("Triangles"), TArray<int32>(View.Triangles) == Triangles);
+
+    for (int32 Index = 0; Index < Positions.Num(); ++Index)
+    {
+      const FString Vertex = FString::Printf(TEXT("vertex %d"), Index);
+      TestTrue(TEXT("Position of ") + Vertex, View.Positions[Index] == Positions[Index]);
+      TestTrue(TEXT("Normal of ") + Vertex,
+        FProceduralCompactMesh::UnpackNormal(View.Normals[Index]).Equals(Normals[Index], 1.e-3f));
+
+      float BinormalSign = 0.0f;
+      const FVector3f Tangent = FProceduralCompactMesh::UnpackTangent(View.Tangents[Index], BinormalSign);
+      TestTrue(TEXT("Tangent of ") + Vertex, Tangent.Equals(Tangents[Index], 1.e-3f));
+      TestEqual(TEXT("Binormal sign of ") + Vertex, BinormalSign, FlipTangentY[Index] ? -1.0f : 1.0f);
+
+      TestTrue(TEXT("UV0 of ") + Vertex, FVector2f(View.UV0[Index]) == UV0[Index]);
+      TestTrue(TEXT("Color of ") + Vertex, View.Colors[Index] == Colors[Index]);
+    }
+  }
+
+  IFileManager::Get().Delete(*Filename);
+  IFileManager::Get().Delete(*ScriptFilename);
+  return true;
+}
+
+#endif
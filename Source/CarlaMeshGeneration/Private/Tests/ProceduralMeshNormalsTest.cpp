@@ -0,0 +1,53 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "Generation/MapGenFunctionLibrary.h"
+
+#include "Materials/Material.h"
+#include "Misc/AutomationTest.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FProceduralMeshComputedNormalsTest,
+  "CarlaMeshGeneration.MeshDescription.ComputedNormals",
+  EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FProceduralMeshComputedNormalsTest::RunTest(const FString& Parameters)
+{
+  // A single triangle without normals, so they are computed while building.
+  FProceduralCompactMesh Mesh;
+  Mesh.Positions = { FVector3f(0.0f, 0.0f, 0.0f), FVector3f(100.0f, 0.0f, 0.0f), FVector3f(0.0f, 100.0f, 0.0f) };
+  Mesh.Triangles = { 0, 1, 2 };
+  Mesh.UV0 = { FVector2DHalf(0.0f, 0.0f), FVector2DHalf(1.0f, 0.0f), FVector2DHalf(0.0f, 1.0f) };
+
+  FMeshDescription Description = UMapGenFunctionLibrary::BuildMeshDescriptionFromCompact(
+    Mesh, UMaterial::GetDefaultMaterial(MD_Surface));
+  if (!TestEqual(TEXT("Triangle count"), Description.Triangles().Num(), 1))
+  {
+    return false;
+  }
+
+  // The engine's own normal for the same winding is the reference.
+  FMeshDescription Reference = Description;
+  FStaticMeshOperations::ComputeTriangleTangentsAndNormals(Reference);
+  const FVector3f Expected = FStaticMeshAttributes(Reference).GetTriangleNormals()[FTriangleID(0)];
+  TestTrue(TEXT("Engine normal of the triangle points down"), Expected.Equals(FVector3f(0.0f, 0.0f, -1.0f), 1.e-4f));
+
+  const TVertexInstanceAttributesConstRef<FVector3f> Normals =
+    FStaticMeshConstAttributes(Description).GetVertexInstanceNormals();
+  for (const FVertexInstanceID VertexInstance : Description.VertexInstances().GetElementIDs())
+  {
+    TestTrue(
+      FString::Printf(TEXT("Computed normal of vertex instance %d matches the engine"), VertexInstance.GetValue()),
+      Normals[VertexInstance].Equals(Expected, 1.e-4f));
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,124 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Vector2DHalf.h"
+#include "ProceduralMeshComponent.h"
+
+#include "Actor/ProceduralCustomMesh.h"
+
+#include "ProceduralCompactMesh.generated.h"
+
+/**
+ * Read-only views of the arrays of a FProceduralCompactMesh, which may also
+ * point into memory that is not owned by one, like a mapped mesh file.
+ */
+struct CARLAMESHGENERATION_API FProceduralCompactMeshView
+{
+  TConstArrayView<FVector3f> Positions;
+  TConstArrayView<int32> Triangles;
+  TConstArrayView<uint32> Normals;
+  TConstArrayView<uint32> Tangents;
+  TConstArrayView<FVector2DHalf> UV0;
+  TConstArrayView<FColor> Colors;
+
+  int32 NumVertices() const { return Positions.Num(); }
+
+  bool HasNormals() const { return Normals.Num() == Positions.Num(); }
+
+  bool HasTangents() const { return Tangents.Num() == Positions.Num(); }
+
+  bool HasUV0() const { return UV0.Num() == Positions.Num(); }
+
+  bool HasColors() const { return Colors.Num() == Positions.Num(); }
+};
+
+/**
+ * The data of a FProceduralCustomMesh at about half its size: float
+ * positions, normals and tangents octahedral encoded into 32 bits each,
+ * half precision UVs and 8-bit colors. Every channel but the positions and
+ * triangles is optional and is either empty or has one entry per vertex.
+ *
+ * The arrays are not reflected, so Blueprint and Python build one with
+ * UMapGenFunctionLibrary::MakeCompactMesh, or load a mesh file with
+ * UMapGenFunctionLibrary::CreateMeshesFromFile, and only C++ reads or fills
+ * them. They are still kept when the struct is saved, copied or duplicated,
+ * through Serialize and the struct's copy operator.
+ */
+USTRUCT(BlueprintType)
+struct CARLAMESHGENERATION_API FProceduralCompactMesh
+{
+  GENERATED_BODY()
+
+  TArray<FVector3f> Positions;
+
+  TArray<int32> Triangles;
+
+  /** See PackNormal. */
+  TArray<uint32> Normals;
+
+  /** See PackTangent. */
+  TArray<uint32> Tangents;
+
+  TArray<FVector2DHalf> UV0;
+
+  /** sRGB, like FColor everywhere else. */
+  TArray<FColor> Colors;
+
+  int32 NumVertices() const { return Positions.Num(); }
+
+  bool HasNormals() const { return Normals.Num() == Positions.Num(); }
+
+  bool HasTangents() const { return Tangents.Num() == Positions.Num(); }
+
+  bool HasUV0() const { return UV0.Num() == Positions.Num(); }
+
+  bool HasColors() const { return Colors.Num() == Positions.Num(); }
+
+  SIZE_T GetAllocatedSize() const;
+
+  bool Serialize(FArchive& Ar);
+
+  bool Identical(const FProceduralCompactMesh* Other, uint32 PortFlags) const;
+
+  FProceduralCompactMeshView GetView() const
+  {
+    return { Positions, Triangles, Normals, Tangents, UV0, Colors };
+  }
+
+  /** Tangents are only kept if there is one per vertex. */
+  static FProceduralCompactMesh FromCustomMesh(
+    const FProceduralCustomMesh& Mesh,
+    const TArray<FProcMeshTangent>& Tangents);
+
+  FProceduralCustomMesh ToCustomMesh(TArray<FProcMeshTangent>* OutTangents = nullptr) const;
+
+  /** A unit vector as two 16-bit signed normalized octahedral coordinates. */
+  static uint32 PackNormal(const FVector3f& Normal);
+
+  static FVector3f UnpackNormal(uint32 Packed);
+
+  /**
+   * Like PackNormal, with the lowest bit holding whether the binormal is
+   * flipped, at the cost of one bit of precision.
+   */
+  static uint32 PackTangent(const FVector3f& TangentX, bool bFlipTangentY);
+
+  static FVector3f UnpackTangent(uint32 Packed, float& OutBinormalSign);
+};
+
+template<>
+struct TStructOpsTypeTraits<FProceduralCompactMesh> : public TStructOpsTypeTraitsBase2<FProceduralCompactMesh>
+{
+  enum
+  {
+    WithSerializer = true,
+    WithCopy = true,
+    WithIdentical = true,
+  };
+};
@@ -0,0 +1,99 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EditorSubsystem.h"
+#include "TickableEditorObject.h"
+
+#include "AssetSaveQueue.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogCarlaAssetSaveQueue, Log, All);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAssetSaveQueueProgress, int32, NumSaved, int32, NumTotal);
+
+/**
+ * Saves generated packages while generation goes on. UObject serialization
+ * has to happen on the game thread, so packages are serialized there, but the
+ * files are written by the async file writer, overlapping disk I/O with
+ * generation. Queued packages are saved in batches as they come in and the
+ * rest over the following editor ticks. Flush saves everything and waits for
+ * the writes.
+ */
+UCLASS()
+class CARLAMESHGENERATION_API UAssetSaveQueueSubsystem : public UEditorSubsystem, public FTickableEditorObject
+{
+  GENERATED_BODY()
+
+public:
+
+  /** Null when there is no editor, e.g. in some commandlets. */
+  static UAssetSaveQueueSubsystem* Get();
+
+  /** Enqueues Package, or saves it right away if there is no queue. */
+  static void EnqueueOrSave(UPackage* Package);
+
+  /** Queues Package to be saved. Queuing a package twice saves it once. */
+  UFUNCTION(BlueprintCallable, Category = "Asset Save Queue")
+  void Enqueue(UPackage* Package);
+
+  /** Saves every queued package and waits until all files are on disk. */
+  UFUNCTION(BlueprintCallable, Category = "Asset Save Queue")
+  void Flush();
+
+  UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Asset Save Queue")
+  int32 GetNumQueued() const { return Queue.Num() - QueueHead; }
+
+  /** Packages saved since the editor started. */
+  UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Asset Save Queue")
+  int32 GetNumSaved() const { return NumSaved; }
+
+  /** Broadcast after every batch of saves. */
+  UPROPERTY(BlueprintAssignable, Category = "Asset Save Queue")
+  FAssetSaveQueueProgress OnProgress;
+
+  /** Queued packages that are saved right away rather than on the next tick. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Save Queue", meta = (ClampMin = "1"))
+  int32 BatchSize = 32;
+
+  /**
+   * Serialized bytes that may wait for the file writer. Saving stops to let
+   * the writes finish past this, which bounds the memory they hold.
+   */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Save Queue", meta = (ClampMin = "1"))
+  int32 MaxInFlightMB = 512;
+
+  /** Time spent saving on every editor tick while packages are queued. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Save Queue", meta = (ClampMin = "0.001"))
+  float TickBudgetSeconds = 0.02f;
+
+  virtual void Deinitialize() override;
+
+  virtual void Tick(float DeltaTime) override;
+  virtual bool IsTickable() const override { return GetNumQueued() > 0; }
+  virtual TStatId GetStatId() const override;
+
+private:
+
+  /** Saves up to MaxPackages queued packages or until Deadline passes. */
+  void SaveQueued(int32 MaxPackages, double Deadline);
+
+  bool SavePackage(UPackage* Package);
+
+  struct FQueuedPackage
+  {
+    FName Name;
+    TWeakObjectPtr<UPackage> Package;
+  };
+
+  TArray<FQueuedPackage> Queue;
+  int32 QueueHead = 0;
+  TSet<FName> QueuedNames;
+
+  int32 NumSaved = 0;
+  int64 InFlightBytes = 0;
+};
@@ -15,13 +15,54 @@
 // Carla C++ headers
 
 // Carla plugin headers
+#include "Actor/ProceduralCompactMesh.h"
 #include "Actor/ProceduralCustomMesh.h"
+#include "Generation/ProceduralMeshBuildSettings.h"
 
 #include "MapGenFunctionLibrary.generated.h"
 
 
 DECLARE_LOG_CATEGORY_EXTERN(LogCarlaMapGenFunctionLibrary, Log, All);
 
+class AStaticMeshActor;
+
+/// One material's worth of geometry in a multi-section mesh.
+USTRUCT(BlueprintType)
+struct CARLAMESHGENERATION_API FProceduralMeshSection
+{
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Section")
+  FProceduralCustomMesh Mesh;
+
+  /** Ignored unless there is one per vertex. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Section")
+  TArray<FProcMeshTangent> Tangents;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Section")
+  UMaterialInterface* Material = nullptr;
+
+  /** Used instead of Mesh and Tangents when it has vertices. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Section")
+  FProceduralCompactMesh CompactMesh;
+};
+
+/// A static mesh to create in a CreateMeshes batch.
+USTRUCT(BlueprintType)
+struct CARLAMESHGENERATION_API FProceduralMeshBatchEntry
+{
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Batch")
+  TArray<FProceduralMeshSection> Sections;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Batch")
+  FString FolderName;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Batch")
+  FName MeshName;
+};
+
 UCLASS(BlueprintType)
 class CARLAMESHGENERATION_API UMapGenFunctionLibrary : public UBlueprintFunctionLibrary
 {
@@ -36,10 +77,146 @@ public:
       FString FolderName,
       FName MeshName);
 
+  /** Same as CreateMesh, with control over how the mesh is built. */
+  UFUNCTION(BlueprintCallable)
+  static UStaticMesh* CreateMeshWithSettings(
+      const FProceduralCustomMesh& Data,
+      const TArray<FProcMeshTangent>& ParamTangents,
+      UMaterialInstance* MaterialInstance,
+      FString MapName,
+      FString FolderName,
+      FName MeshName,
+      const FProceduralMeshBuildSettings& BuildSettings);
+
+  /** Same as CreateMeshWithSettings, from the compact form of the data. */
+  UFUNCTION(BlueprintCallable)
+  static UStaticMesh* CreateMeshFromCompact(
+      const FProceduralCompactMesh& Data,
+      UMaterialInterface* Material,
+      FString MapName,
+      FString FolderName,
+      FName MeshName,
+      const FProceduralMeshBuildSettings& BuildSettings);
+
+  UFUNCTION(BlueprintCallable, BlueprintPure)
+  static FProceduralCompactMesh MakeCompactMesh(
+      const FProceduralCustomMesh& Data,
+      const TArray<FProcMeshTangent>& ParamTangents);
+
+  /**
+   * Builds a single static mesh with one section per distinct material, so
+   * e.g. a road with its markings, curbs and sidewalks is one asset and one
+   * build instead of one per material.
+   */
+  UFUNCTION(BlueprintCallable)
+  static UStaticMesh* CreateMeshFromSections(
+      const TArray<FProceduralMeshSection>& Sections,
+      FString MapName,
+      FString FolderName,
+      FName MeshName,
+      const FProceduralMeshBuildSettings& BuildSettings);
+
+  /**
+   * Creates many static meshes at once. The mesh descriptions are built in
+   * parallel and all meshes go through a single batch build, so the engine
+   * can spread them over its build workers. The result has one entry per
+   * input entry, null for entries without triangles.
+   */
+  UFUNCTION(BlueprintCallable)
+  static TArray<UStaticMesh*> CreateMeshes(
+      const TArray<FProceduralMeshBatchEntry>& Entries,
+      FString MapName,
+      const FProceduralMeshBuildSettings& BuildSettings);
+
+  /**
+   * Creates a static mesh for every mesh in a file written by the Python
+   * pipeline, see FProceduralMeshFile, named as in the file. The file is
+   * memory mapped and its meshes built in place, in one batch like
+   * CreateMeshes. Meshes without a material path in the file get
+   * DefaultMaterial.
+   */
+  UFUNCTION(BlueprintCallable)
+  static TArray<UStaticMesh*> CreateMeshesFromFile(
+      FString Filename,
+      UMaterialInterface* DefaultMaterial,
+      FString MapName,
+      FString FolderName,
+      const FProceduralMeshBuildSettings& BuildSettings);
+
+  /**
+   * Splits the sections into CellSize squares of the XY plane and creates
+   * one static mesh per cell, named MeshName_X_Y, so the geometry can be
+   * culled and streamed per cell. Each mesh has its pivot at the center of
+   * its cell, which OutOrigins receives.
+   */
+  UFUNCTION(BlueprintCallable)
+  static TArray<UStaticMesh*> CreateChunkedMeshes(
+      const TArray<FProceduralMeshSection>& Sections,
+      FString MapName,
+      FString FolderName,
+      FName MeshName,
+      float CellSize,
+      const FProceduralMeshBuildSettings& BuildSettings,
+      TArray<FVector>& OutOrigins);
+
+  /**
+   * Places each mesh at its origin in a spatially loaded static mesh actor,
+   * so World Partition streams it with the cell it falls into.
+   */
+  UFUNCTION(BlueprintCallable, meta = (WorldContext = "WorldContextObject"))
+  static TArray<AStaticMeshActor*> SpawnChunkActors(
+      UObject* WorldContextObject,
+      const TArray<UStaticMesh*>& Meshes,
+      const TArray<FVector>& Origins,
+      FName FolderPath);
+
+  /**
+   * Merges the static mesh components of Actors into one static mesh per
+   * cell, with one section per material, and a decimated proxy of it drawn
+   * from MergeSettings.ProxyDistance on. The merging runs in parallel and the
+   * meshes go through one batch build. Each cell gets a spatially loaded
+   * actor holding both meshes, which is returned. Instanced and movable
+   * components are left alone.
+   */
+  UFUNCTION(BlueprintCallable)
+  static TArray<AStaticMeshActor*> MergeActorsByCell(
+      const TArray<AActor*>& Actors,
+      FString MapName,
+      FString FolderName,
+      FName MeshName,
+      const FProceduralMeshMergeSettings& MergeSettings,
+      const FProceduralMeshBuildSettings& BuildSettings);
+
+  /**
+   * Normals missing from the data are computed from the triangles, and
+   * missing tangents with MikkTSpace, so callers may pass positions,
+   * triangles and UVs only.
+   */
   static FMeshDescription BuildMeshDescriptionFromData(
       const FProceduralCustomMesh& Data,
       const TArray<FProcMeshTangent>& ParamTangents,
-      UMaterialInstance* MaterialInstance );
+      UMaterialInstance* MaterialInstance,
+      const FProceduralMeshBuildSettings& BuildSettings = FProceduralMeshBuildSettings());
+
+  static FMeshDescription BuildMeshDescriptionFromCompact(
+      const FProceduralCompactMesh& Data,
+      UMaterialInterface* Material,
+      const FProceduralMeshBuildSettings& BuildSettings = FProceduralMeshBuildSettings());
+
+  /** Reads the data in place, e.g. straight from a mapped FProceduralMeshFile. */
+  static FMeshDescription BuildMeshDescriptionFromCompact(
+      const FProceduralCompactMeshView& Data,
+      UMaterialInterface* Material,
+      const FProceduralMeshBuildSettings& BuildSettings = FProceduralMeshBuildSettings());
+
+  /**
+   * Sections with the same material go into the same polygon group.
+   * OutMaterials receives the material of each polygon group.
+   */
+  static FMeshDescription BuildMeshDescriptionFromSections(
+      const TArray<FProceduralMeshSection>& Sections,
+      const FProceduralMeshBuildSettings& BuildSettings = FProceduralMeshBuildSettings(),
+      TArray<UMaterialInterface*>* OutMaterials = nullptr);
 
   UFUNCTION(BlueprintCallable)
   static FVector2D GetTransversemercProjection(float lat, float lon, float lat0, float lon0);
@@ -65,6 +242,12 @@ public:
   UFUNCTION(BlueprintCallable)
   static USceneComponent* AddSceneComponentToActor(AActor* TargetActor);
 
+  /** For each point, whether its XY lies inside the closed XY polygon. */
+  UFUNCTION(BlueprintCallable)
+  static TArray<bool> ArePointsInsidePolygon(
+    const TArray<FVector>& Polygon,
+    const TArray<FVector>& Points);
+
   UFUNCTION(BlueprintCallable)
   static void SmoothVerticesDeep(
     TArray<FVector>& Vertices,
@@ -0,0 +1,111 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+/**
+ * On-disk store of Poisson disc sampling results. Entries are keyed by a hash
+ * of everything that affects the sampler output and live under
+ * Saved/CarlaMeshGeneration/PoissonCache, so they survive editor restarts and
+ * are shared between generation jobs.
+ *
+ * The directory is kept under CarlaMeshGeneration.PoissonCache.MaxSizeMB by
+ * deleting the least recently used entries when a store goes over it, and
+ * CarlaMeshGeneration.PoissonCache.Clear empties it.
+ */
+class CARLAMESHGENERATION_API FPoissonDiscCache
+{
+public:
+
+  static FPoissonDiscCache& Get();
+
+  /** Returns true and fills OutPoints if an entry exists for Key. */
+  bool Load(uint64 Key, TArray<FVector2f>& OutPoints) const;
+
+  void Store(uint64 Key, TConstArrayView<FVector2f> Points);
+
+  /** Deletes every entry. */
+  void Clear();
+
+  FString GetCacheDirectory() const;
+
+private:
+
+  FString GetEntryPath(uint64 Key) const;
+
+  /**
+   * Deletes the least recently used entries until the rest take at most
+   * TargetBytes. Lock must be held.
+   */
+  void Trim(int64 TargetBytes);
+
+  FCriticalSection Lock;
+
+  /** Size of all entries, or -1 until the directory is first listed. */
+  int64 TotalBytes = -1;
+};
+
+/**
+ * In-memory record of the last points sampled for every spline input, used to
+ * resample only the part of a spline an edit touched. Entries are keyed by the
+ * component they came from and a stable id of the node and input. Once they
+ * take more than CarlaMeshGeneration.PoissonIncremental.MaxSizeMB the least
+ * recently used are evicted, and RemoveStale drops those of destroyed
+ * components.
+ */
+class CARLAMESHGENERATION_API FPoissonIncrementalStore
+{
+public:
+
+  struct FKey
+  {
+    /** Stays distinct from any later object once the owner is destroyed. */
+    FObjectKey Owner;
+
+    /** Identifies the node and input within the owner. */
+    uint64 Id = 0;
+
+    bool IsSet() const { return Owner != FObjectKey(); }
+
+    friend bool operator==(const FKey& A, const FKey& B) { return A.Owner == B.Owner && A.Id == B.Id; }
+
+    friend uint32 GetTypeHash(const FKey& Key) { return HashCombineFast(GetTypeHash(Key.Owner), GetTypeHash(Key.Id)); }
+  };
+
+  struct FEntry
+  {
+    /** Hash of the seed and settings the points were sampled with. */
+    uint64 SettingsKey = 0;
+    TArray<FVector3f> SplineVertices;
+    TArray<FVector2f> Points;
+  };
+
+  static FPoissonIncrementalStore& Get();
+
+  TSharedPtr<const FEntry> Find(const FKey& Key);
+
+  void Store(const FKey& Key, TSharedRef<const FEntry> Entry);
+
+  /** Drops the entries of destroyed owners. Game thread only. */
+  void RemoveStale();
+
+private:
+
+  struct FSlot
+  {
+    TSharedRef<const FEntry> Entry;
+    SIZE_T Size;
+    uint64 LastUse;
+  };
+
+  FCriticalSection Lock;
+  TMap<FKey, FSlot> Entries;
+  SIZE_T TotalSize = 0;
+  uint64 UseCount = 0;
+};
@@ -0,0 +1,98 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+class FPolygonIndex2D;
+
+/**
+ * Counter-based generator: every draw is a pure integer function of (Key,
+ * Counter), so the sequence does not depend on the standard library's engines
+ * or distributions and is identical on every platform and compiler.
+ */
+struct FPoissonRandom
+{
+  uint64 Key;
+  uint64 Counter = 0;
+
+  explicit FPoissonRandom(uint64 InKey) : Key(InKey) {}
+
+  static uint64 Mix(uint64 X)
+  {
+    X ^= X >> 30;
+    X *= 0xBF58476D1CE4E5B9ull;
+    X ^= X >> 27;
+    X *= 0x94D049BB133111EBull;
+    return X ^ (X >> 31);
+  }
+
+  uint64 NextU64()
+  {
+    return Mix(Key + 0x9E3779B97F4A7C15ull * ++Counter);
+  }
+
+  // Uniform in [0, 1) with 24 bits of precision.
+  float NextUnit()
+  {
+    return (float)(NextU64() >> 40) * (float)(1.0 / 16777216.0);
+  }
+
+  // Uniform in [0, N).
+  int32 NextIndex(int32 N)
+  {
+    return (int32)(((NextU64() >> 32) * (uint64)N) >> 32);
+  }
+};
+
+struct FPoissonDiscSamplerParams
+{
+  /** Area new points are placed in. */
+  FBox2f Bounds = FBox2f(ForceInit);
+
+  /** If set, points are only placed inside this polygon. */
+  const FPolygonIndex2D* Polygon = nullptr;
+
+  /**
+   * Points already placed. New points keep MinDistance from them and grow
+   * outwards from them, but they are not returned. Points farther than
+   * MinDistance outside Bounds are ignored.
+   */
+  TConstArrayView<FVector2f> FixedPoints;
+
+  float MinDistance = 100.0f;
+  int32 MaxRetries = 32;
+  uint64 Seed = 0;
+
+  /** Sample independent tiles of the grid on multiple threads. */
+  bool bParallel = true;
+
+  /** Memory the dense background grid may use before falling back to pages. Does not change the points. */
+  int32 GridMemoryBudgetMB = 256;
+
+  /** Polled between tiles. A cancelled run returns no points. */
+  const std::atomic<bool>* bCancelled = nullptr;
+};
+
+/**
+ * Bridson-style Poisson disc sampler over a 2D area. The result only depends
+ * on the parameters, not on the number of threads.
+ */
+class CARLAMESHGENERATION_API FPoissonDiscSampler
+{
+public:
+
+  /**
+   * Bump whenever a change to the sampler alters its output for the same
+   * inputs, so stale entries in FPoissonDiscCache are not reused.
+   */
+  static constexpr uint32 Version = 6;
+
+  static TArray<FVector2f> Generate(const FPoissonDiscSamplerParams& Params);
+};
@@ -7,10 +7,34 @@
 #pragma once
 
 // Engine headers
+#include "PCGContext.h"
 #include "PCGSettings.h"
 #include "Metadata/PCGAttributePropertySelector.h"
+#include "Tasks/Task.h"
+
+#include "Generation/PoissonDiscCache.h"
+
+#include <atomic>
+
 #include "PoissonDiscSampling.generated.h"
 
+class UPCGSplineData;
+class UPoissonTileSet;
+struct FPoissonTileSetData;
+
+UENUM(BlueprintType)
+enum class EPoissonDiscSamplingMode : uint8
+{
+  /** Grow points one by one, rejecting candidates closer than MinDistance. */
+  Bridson,
+
+  /**
+   * Stamp precomputed Poisson tiles scaled to MinDistance. Each point costs
+   * about as much as a copy, at the price of a fixed coverage pattern.
+   */
+  TileSet
+};
+
 /**
  * Various fractal noises that can be used to filter points
  */
@@ -28,6 +52,7 @@ public:
   virtual FText GetDefaultNodeTitle() const override { return NSLOCTEXT("PCGPoissonDiscSampling", "NodeTitle", "Poisson Disc Sampling"); }
   virtual EPCGSettingsType GetType() const override { return EPCGSettingsType::Spatial; }
 #endif
+  virtual bool UseSeed() const override { return true; }
 
 protected:
   virtual TArray<FPCGPinProperties> InputPinProperties() const override;
@@ -45,19 +70,94 @@ public:
   float MinDistance = 100.0F;
 
   UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings)
+  EPoissonDiscSamplingMode SamplingMode = EPoissonDiscSamplingMode::Bridson;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings, meta = (EditCondition = "SamplingMode == EPoissonDiscSamplingMode::Bridson"))
   int32 MaxRetries = 32;
 
+  /** Tiles to stamp. If unset, a tile set generated on first use is used. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings, meta = (EditCondition = "SamplingMode == EPoissonDiscSamplingMode::TileSet"))
+  TSoftObjectPtr<UPoissonTileSet> TileSet;
+
   UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings)
   bool bFilterInsideSpline = true;
 
+  /** Sample input splines, and independent tiles of large areas, on multiple threads. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings)
+  bool bParallelSampling = true;
+
+  /**
+   * Memory the sampler may spend on a dense background grid. Larger areas fall
+   * back to a sparse grid that only allocates the pages points land in. The
+   * sampled points are the same either way.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings, AdvancedDisplay, meta = (ClampMin = "1"))
+  int32 GridMemoryBudgetMB = 256;
+
+  /** Reuse results stored on disk for identical spline, seed and settings. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings, meta = (EditCondition = "SamplingMode == EPoissonDiscSamplingMode::Bridson"))
+  bool bUsePointCache = true;
+
+  /**
+   * When a spline is edited, keep the points from the previous run away from
+   * the edit and only resample around it. Layouts stay stable and the cost
+   * follows the size of the edit, but the points then depend on the edit
+   * history, so updated points are not cached on disk.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings, meta = (EditCondition = "SamplingMode == EPoissonDiscSamplingMode::Bridson"))
+  bool bIncrementalResampling = false;
+
+  /**
+   * Output points along a Z-order curve instead of in sampling order, so
+   * points next to each other in the output are also close in space.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Settings)
+  bool bSortByMortonOrder = false;
+
+};
+
+/**
+ * Execution state of a Poisson disc sampling node. Every input spline is
+ * sampled by its own task while the element polls them, so the node yields
+ * between frames instead of blocking until all splines are done.
+ */
+struct FPCGPoissonDiscSamplingContext : public FPCGContext
+{
+  virtual ~FPCGPoissonDiscSamplingContext();
+
+  struct FSplineJob
+  {
+    const UPCGSplineData* Spline = nullptr;
+    // Identifies this input across executions for incremental resampling.
+    FPoissonIncrementalStore::FKey IncrementalKey;
+    UE::Tasks::FTask Task;
+    TArray<FVector> Points;
+  };
+
+  // One job per valid input spline, in input order.
+  TArray<FSplineJob> Jobs;
+  int32 NextJobToOutput = 0;
+  bool bJobsCreated = false;
+
+  // Tiles stamped by the jobs in tile set mode.
+  TSharedPtr<const FPoissonTileSetData> TileSet;
+
+  // Set when the node is aborted; running jobs stop at the next tile.
+  std::atomic<bool> bCancelled = false;
 };
 
 class FPCGPoissonDiscSampling : public IPCGElement
 {
 protected:
 
+	virtual FPCGContext* CreateContext() override { return new FPCGPoissonDiscSamplingContext(); }
+
 	virtual bool ExecuteInternal(FPCGContext* Context) const override;
 
+	virtual void AbortInternal(FPCGContext* Context) const override;
+
+	virtual bool CanExecuteOnlyOnMainThread(FPCGContext* Context) const override;
+
 	virtual EPCGElementExecutionLoopMode ExecutionLoopMode(
         const UPCGSettings* Settings) const override
     {
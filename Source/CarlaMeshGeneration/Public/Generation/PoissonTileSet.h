@@ -0,0 +1,148 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+
+#include "PoissonTileSet.generated.h"
+
+class FPolygonIndex2D;
+
+USTRUCT()
+struct FPoissonTilePatch
+{
+  GENERATED_BODY()
+
+  /** Points in tile units, relative to the lattice vertex the patch starts at. */
+  UPROPERTY()
+  TArray<FVector2f> Points;
+};
+
+/**
+ * Set of Poisson disc patches, sampled with a minimum distance of one, that
+ * tile the plane without seams. The plane is split into a square lattice
+ * whose vertices take one of NumCornerColors colours and whose edges take one
+ * of NumEdgeVariants variants, both picked by hashing the lattice coordinates.
+ * Every vertex, edge and cell interior has a patch for each combination of the
+ * colours and variants it touches, generated around the patches it borders,
+ * so any arrangement keeps the minimum distance across patch borders while the
+ * hash keeps the arrangement from repeating.
+ */
+USTRUCT()
+struct CARLAMESHGENERATION_API FPoissonTileSetData
+{
+  GENERATED_BODY()
+
+  /** Side of a lattice cell, in units of the minimum distance. */
+  UPROPERTY(VisibleAnywhere, Category = "Tile Set")
+  float TileSize = 0.0f;
+
+  UPROPERTY(VisibleAnywhere, Category = "Tile Set")
+  int32 NumCornerColors = 0;
+
+  UPROPERTY(VisibleAnywhere, Category = "Tile Set")
+  int32 NumEdgeVariants = 0;
+
+  /** Indexed by corner colour. */
+  UPROPERTY()
+  TArray<FPoissonTilePatch> Corners;
+
+  /** Edges from a vertex to the next one along X, indexed by GetEdgeIndex. */
+  UPROPERTY()
+  TArray<FPoissonTilePatch> HorizontalEdges;
+
+  /** Edges from a vertex to the next one along Y, indexed by GetEdgeIndex. */
+  UPROPERTY()
+  TArray<FPoissonTilePatch> VerticalEdges;
+
+  /** Indexed by GetInteriorIndex. */
+  UPROPERTY()
+  TArray<FPoissonTilePatch> Interiors;
+
+  bool IsValid() const;
+
+  /**
+   * Generates every patch with the Poisson disc sampler. Runs in parallel and
+   * takes well under a second for the default sizes.
+   */
+  static FPoissonTileSetData Generate(
+    uint64 Seed,
+    float InTileSize = 8.0f,
+    int32 InNumCornerColors = 2,
+    int32 InNumEdgeVariants = 2,
+    int32 MaxRetries = 64);
+
+  /** Tile set generated once on first use, for nodes without an asset. */
+  static TSharedRef<const FPoissonTileSetData> GetDefault();
+
+  /**
+   * Appends the points of the tiles covering Bounds, scaled so that they are
+   * at least MinDistance apart. Points outside Bounds, or outside Polygon if
+   * it is set, are dropped.
+   */
+  void Stamp(
+    const FBox2f& Bounds,
+    float MinDistance,
+    uint64 Seed,
+    const FPolygonIndex2D* Polygon,
+    TArray<FVector2f>& OutPoints) const;
+
+private:
+
+  int32 GetEdgeIndex(int32 StartColor, int32 EndColor, int32 Variant) const
+  {
+    return (StartColor * NumCornerColors + EndColor) * NumEdgeVariants + Variant;
+  }
+
+  // Corners are listed counter-clockwise from the lower left, edges as
+  // bottom, right, top and left.
+  int32 GetInteriorIndex(const int32 (&CornerColors)[4], const int32 (&EdgeVariants)[4]) const
+  {
+    int32 Index = 0;
+    for (int32 Color : CornerColors)
+      Index = Index * NumCornerColors + Color;
+    for (int32 Variant : EdgeVariants)
+      Index = Index * NumEdgeVariants + Variant;
+    return Index;
+  }
+};
+
+/**
+ * Asset holding a precomputed Poisson tile set for the Poisson disc sampling
+ * node. The tiles are regenerated in the editor with the Generate button.
+ */
+UCLASS(BlueprintType)
+class CARLAMESHGENERATION_API UPoissonTileSet : public UDataAsset
+{
+  GENERATED_BODY()
+
+public:
+
+  UPROPERTY(EditAnywhere, Category = "Generation")
+  int32 Seed = 0;
+
+  /** Side of a tile, in units of the minimum distance. */
+  UPROPERTY(EditAnywhere, Category = "Generation", meta = (ClampMin = "6.0"))
+  float TileSize = 8.0f;
+
+  /** More colours and variants make repetition less visible at the cost of more tiles. */
+  UPROPERTY(EditAnywhere, Category = "Generation", meta = (ClampMin = "1", ClampMax = "3"))
+  int32 NumCornerColors = 2;
+
+  UPROPERTY(EditAnywhere, Category = "Generation", meta = (ClampMin = "1", ClampMax = "3"))
+  int32 NumEdgeVariants = 2;
+
+  UPROPERTY(EditAnywhere, Category = "Generation", meta = (ClampMin = "1"))
+  int32 MaxRetries = 64;
+
+  UPROPERTY(VisibleAnywhere, Category = "Tile Set")
+  FPoissonTileSetData Data;
+
+  UFUNCTION(CallInEditor, Category = "Generation")
+  void Generate();
+};
@@ -0,0 +1,134 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "ProceduralMeshBuildSettings.generated.h"
+
+UENUM(BlueprintType)
+enum class EProceduralMeshCollision : uint8
+{
+  /** The render triangles are used for every query. Exact but the most expensive. */
+  ComplexAsSimple,
+
+  /** Convex hulls around up to MaxConvexHulls parts of the mesh. Suited to buildings. */
+  ConvexDecomposition,
+
+  /** A box around the triangles in each CollisionCellSize cell of the XY plane. Suited to flat roads. */
+  Boxes,
+
+  /** A copy of the mesh decimated to CollisionTriangleBudget triangles. */
+  SimplifiedComplex,
+
+  NoCollision
+};
+
+UENUM(BlueprintType)
+enum class EProceduralMeshNanite : uint8
+{
+  /**
+   * Nanite for meshes with at least NaniteMinTriangles triangles and no
+   * translucent material, LODs for the rest.
+   */
+  Auto,
+  Enabled,
+  Disabled
+};
+
+/// Options for turning an FProceduralCustomMesh into a static mesh.
+USTRUCT(BlueprintType)
+struct CARLAMESHGENERATION_API FProceduralMeshBuildSettings
+{
+  GENERATED_BODY()
+
+  /**
+   * Merge vertices closer than WeldTolerance and share one vertex instance
+   * between the corners that use the same vertex with the same attributes.
+   * Triangles that collapse are dropped.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Welding")
+  bool bWeldVertices = false;
+
+  /** In centimeters. Zero only merges vertices at exactly the same position. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Welding", meta = (ClampMin = "0.0", EditCondition = "bWeldVertices"))
+  float WeldTolerance = 0.01f;
+
+  /**
+   * Queue the packages of the created meshes on the asset save queue instead
+   * of leaving them dirty for a later save.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Saving")
+  bool bSavePackages = false;
+
+  /**
+   * Return the existing mesh at the target path, without rebuilding or
+   * saving it, if it was generated from the same inputs and settings.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Saving")
+  bool bReuseUnchangedMeshes = true;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Collision")
+  EProceduralMeshCollision Collision = EProceduralMeshCollision::ComplexAsSimple;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Collision", meta = (ClampMin = "1", EditCondition = "Collision == EProceduralMeshCollision::ConvexDecomposition"))
+  int32 MaxConvexHulls = 8;
+
+  /** In centimeters. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Collision", meta = (ClampMin = "1.0", EditCondition = "Collision == EProceduralMeshCollision::Boxes"))
+  float CollisionCellSize = 1000.0f;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Collision", meta = (ClampMin = "4", EditCondition = "Collision == EProceduralMeshCollision::SimplifiedComplex"))
+  int32 CollisionTriangleBudget = 2000;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Rendering")
+  EProceduralMeshNanite Nanite = EProceduralMeshNanite::Enabled;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Rendering", meta = (ClampMin = "0", EditCondition = "Nanite == EProceduralMeshNanite::Auto"))
+  int32 NaniteMinTriangles = 5000;
+
+  /**
+   * Screen size at which each LOD after the first takes over, largest first.
+   * Only meshes without Nanite get LODs. Empty means a single LOD.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Rendering")
+  TArray<float> LODScreenSizes;
+
+  /** Fraction of the previous LOD's triangles that each LOD keeps. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Rendering", meta = (ClampMin = "0.01", ClampMax = "1.0"))
+  float LODTriangleRatio = 0.5f;
+};
+
+/// Options for UMapGenFunctionLibrary::MergeActorsByCell.
+USTRUCT(BlueprintType)
+struct CARLAMESHGENERATION_API FProceduralMeshMergeSettings
+{
+  GENERATED_BODY()
+
+  /** In centimeters. Components are assigned to a cell by their bounds' center. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Merging", meta = (ClampMin = "100.0"))
+  float CellSize = 25600.0f;
+
+  /**
+   * Distance in centimeters from which a cell draws its proxy instead of its
+   * merged mesh. Zero creates no proxies.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Proxy", meta = (ClampMin = "0.0"))
+  float ProxyDistance = 50000.0f;
+
+  /** Fraction of the merged mesh's triangles that its proxy keeps. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Proxy", meta = (ClampMin = "0.001", ClampMax = "1.0"))
+  float ProxyTriangleRatio = 0.1f;
+
+  /**
+   * Destroy the merged components, and the actors whose root they were when
+   * nothing else in the actor renders. Off by default, so merging leaves
+   * the level's actors as they were.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Merging")
+  bool bRemoveSourceComponents = false;
+};
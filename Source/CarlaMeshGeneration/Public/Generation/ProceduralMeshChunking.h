@@ -0,0 +1,52 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+
+#include "Actor/ProceduralCustomMesh.h"
+
+/// The part of a mesh inside one cell of the chunking grid.
+struct CARLAMESHGENERATION_API FProceduralMeshChunk
+{
+  FIntPoint Cell;
+
+  /** Center of the cell at Z = 0. The vertices are relative to it. */
+  FVector Origin;
+
+  FProceduralCustomMesh Mesh;
+
+  /** Empty unless the input had one tangent per vertex. */
+  TArray<FProcMeshTangent> Tangents;
+};
+
+/**
+ * Splits meshes into square cells of the XY plane, so a road network or a
+ * terrain can be streamed and culled per cell instead of as a whole.
+ */
+class CARLAMESHGENERATION_API FProceduralMeshChunking
+{
+public:
+
+  /** The cell whose square, [Cell * CellSize, (Cell + 1) * CellSize), holds Position. */
+  static FIntPoint GetCell(const FVector& Position, float CellSize);
+
+  static FVector GetCellOrigin(const FIntPoint& Cell, float CellSize);
+
+  /**
+   * Triangles that cross a cell border are clipped against it, and normals,
+   * UVs, colors and tangents interpolated at the cut, so the chunks meet
+   * without gaps or seams. A cut edge shared by two triangles is cut at the
+   * same point for both. The chunks are sorted by cell. No chunks, with the
+   * error logged, if a triangle refers to a missing vertex.
+   */
+  static TArray<FProceduralMeshChunk> Split(
+    const FProceduralCustomMesh& Data,
+    const TArray<FProcMeshTangent>& Tangents,
+    float CellSize);
+};
@@ -0,0 +1,60 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MeshDescription.h"
+#include "PhysicsEngine/AggregateGeom.h"
+
+#include "Generation/ProceduralMeshBuildSettings.h"
+
+/**
+ * Collision proxies for generated meshes. Everything here only reads the
+ * mesh description and touches no UObject, so it runs on worker threads.
+ */
+class CARLAMESHGENERATION_API FProceduralMeshCollision
+{
+public:
+
+  /**
+   * Builds the collision that BuildSettings.Collision asks for: simple shapes
+   * go to OutSimple and a decimated mesh to OutComplex. Policies that need
+   * neither leave both empty.
+   */
+  static void Build(
+    const FMeshDescription& Description,
+    const FProceduralMeshBuildSettings& BuildSettings,
+    FKAggregateGeom& OutSimple,
+    FMeshDescription& OutComplex);
+
+  /** A box around the triangles whose centroid falls in each XY cell. */
+  static void BuildBoxes(
+    TConstArrayView<FVector3f> Positions,
+    TConstArrayView<FIntVector> Triangles,
+    float CellSize,
+    FKAggregateGeom& OutSimple);
+
+  /**
+   * Splits the triangles into up to MaxHulls parts, always halving the part
+   * with the largest bounds along its longest axis, and wraps each part in a
+   * convex element. Physics cooking computes the hull of each part.
+   */
+  static void BuildConvexParts(
+    TConstArrayView<FVector3f> Positions,
+    TConstArrayView<FIntVector> Triangles,
+    int32 MaxHulls,
+    FKAggregateGeom& OutSimple);
+
+  /**
+   * Welds coincident positions and decimates the result with quadric error
+   * simplification down to TriangleBudget triangles.
+   */
+  static FMeshDescription BuildSimplifiedMesh(
+    TConstArrayView<FVector3f> Positions,
+    TConstArrayView<FIntVector> Triangles,
+    int32 TriangleBudget);
+};
@@ -0,0 +1,95 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Actor/ProceduralCompactMesh.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogCarlaProceduralMeshFile, Log, All);
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * A file of meshes written by the Python pipeline, see
+ * Content/Python/carla_mesh_file.py. The file is memory mapped and its
+ * meshes are read in place as FProceduralCompactMeshView, without copying
+ * them or going through the reflection layer.
+ *
+ * Layout, all little-endian. Offsets are from the start of the file, and
+ * every block starts at a multiple of 16 bytes:
+ *
+ *   Header, 32 bytes:
+ *     0   char[4]  Magic, "CMGM"
+ *     4   uint32   Version, 1
+ *     8   uint32   Number of meshes
+ *     12  uint32   Reserved, 0
+ *     16  uint64   Offset of the mesh table
+ *     24  uint64   Reserved, 0
+ *
+ *   Mesh table, 96 bytes per mesh:
+ *     0   uint64   Offset of the name, UTF-8 without terminator
+ *     8   uint32   Length of the name in bytes
+ *     12  uint32   Length of the material path in bytes, 0 for none
+ *     16  uint64   Offset of the material path, UTF-8 without terminator
+ *     24  uint32   Number of vertices
+ *     28  uint32   Number of triangle indices, a multiple of 3
+ *     32  uint64   Positions, float32 x, y, z per vertex, in centimeters
+ *     40  uint64   Triangles, int32 per index
+ *     48  uint64   Normals, uint32 per vertex, or 0 if absent
+ *     56  uint64   Tangents, uint32 per vertex, or 0 if absent
+ *     64  uint64   UV0, float16 u, v per vertex, or 0 if absent
+ *     72  uint64   Colors, uint8 b, g, r, a per vertex in sRGB, or 0 if absent
+ *     80  uint64   Reserved, 0
+ *     88  uint64   Reserved, 0
+ *
+ * Normals and tangents are packed as by FProceduralCompactMesh::PackNormal
+ * and PackTangent. Mesh names become asset names, so they must be non-empty
+ * and free of spaces, dots, slashes and the other characters asset names
+ * cannot hold. Material paths are object paths, e.g.
+ * "/Game/Materials/M_Road.M_Road".
+ */
+class CARLAMESHGENERATION_API FProceduralMeshFile
+{
+public:
+
+  static constexpr uint32 Version = 1;
+
+  /**
+   * Maps and validates the file, including its mesh names and material
+   * paths. Null, with the reason logged, if it is not a valid mesh file.
+   */
+  static TUniquePtr<FProceduralMeshFile> Open(const FString& Filename);
+
+  ~FProceduralMeshFile();
+
+  int32 NumMeshes() const { return Meshes.Num(); }
+
+  const FString& GetMeshName(int32 Index) const { return Meshes[Index].Name; }
+
+  /** Empty if the file names no material for the mesh. */
+  const FString& GetMaterialPath(int32 Index) const { return Meshes[Index].MaterialPath; }
+
+  /** Valid as long as this file is open. */
+  const FProceduralCompactMeshView& GetMesh(int32 Index) const { return Meshes[Index].View; }
+
+private:
+
+  FProceduralMeshFile() = default;
+
+  struct FMesh
+  {
+    FString Name;
+    FString MaterialPath;
+    FProceduralCompactMeshView View;
+  };
+
+  TUniquePtr<IMappedFileHandle> Handle;
+  TUniquePtr<IMappedFileRegion> Region;
+  TArray<FMesh> Meshes;
+};
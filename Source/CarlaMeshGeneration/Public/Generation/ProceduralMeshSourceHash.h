@@ -0,0 +1,45 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+
+#include "ProceduralMeshSourceHash.generated.h"
+
+class UStaticMesh;
+
+/**
+ * Hash of everything a generated static mesh was built from, stored on the
+ * mesh so that generating it again from the same inputs can return the
+ * existing asset instead of rebuilding and resaving it.
+ */
+UCLASS()
+class CARLAMESHGENERATION_API UProceduralMeshSourceHash : public UAssetUserData
+{
+  GENERATED_BODY()
+
+public:
+
+  /**
+   * Bump whenever a change to mesh generation alters its output for the same
+   * inputs, so assets generated before the change are rebuilt.
+   */
+  static constexpr uint64 GeneratorVersion = 5;
+
+  UPROPERTY(VisibleAnywhere, Category = "Generation")
+  uint64 Hash = 0;
+
+  /**
+   * Returns the mesh named MeshName in PackageName, loading it if needed, if
+   * it was generated from inputs with this hash. Returns null otherwise.
+   */
+  static UStaticMesh* FindUnchangedMesh(const FString& PackageName, FName MeshName, uint64 Hash);
+
+  /** Records on Mesh the hash of the inputs it was generated from. */
+  static void SetHash(UStaticMesh* Mesh, uint64 Hash);
+};
@@ -0,0 +1,124 @@
+// Copyright (c) 2025 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Point-in-polygon index for a closed 2D polygon, using the nonzero winding
+ * rule. Edges are bucketed into horizontal slabs, so a query only visits the
+ * few edges spanning its Y instead of the whole outline. Slab edges are kept
+ * as flat arrays and tested without branches, which lets the compiler
+ * vectorize the crossing count.
+ */
+class CARLAMESHGENERATION_API FPolygonIndex2D
+{
+public:
+
+  FPolygonIndex2D() = default;
+
+  /** The polygon is closed implicitly from the last vertex to the first. */
+  explicit FPolygonIndex2D(TConstArrayView<FVector2f> InVertices);
+
+  void Build(TConstArrayView<FVector2f> InVertices);
+
+  bool IsEmpty() const { return Vertices.Num() < 3; }
+
+  const FBox2f& GetBounds() const { return Bounds; }
+
+  TConstArrayView<FVector2f> GetVertices() const { return Vertices; }
+
+  int32 GetWindingNumber(const FVector2f& Point) const;
+
+  bool IsInside(const FVector2f& Point) const { return GetWindingNumber(Point) != 0; }
+
+  /** Classifies all points in parallel. OutInside must have Points.Num() elements. */
+  void ClassifyPoints(TConstArrayView<FVector2f> Points, TArrayView<bool> OutInside) const;
+
+  /**
+   * Appends the X coordinate and winding direction of every edge crossing the
+   * horizontal line at Y, in no particular order.
+   */
+  void GetCrossings(float Y, TArray<TPair<float, int32>>& OutCrossings) const;
+
+private:
+
+  int32 GetSlab(float Y) const;
+
+  TArray<FVector2f> Vertices;
+  FBox2f Bounds = FBox2f(ForceInit);
+
+  float InvSlabHeight = 0.0f;
+  int32 NumSlabs = 0;
+
+  // Edges of slab i are [SlabOffsets[i], SlabOffsets[i + 1]), each stored as
+  // the lower endpoint, the Y of the upper endpoint, dX/dY and the winding
+  // direction.
+  TArray<int32> SlabOffsets;
+  TArray<float> EdgeX0;
+  TArray<float> EdgeY0;
+  TArray<float> EdgeY1;
+  TArray<float> EdgeSlope;
+  TArray<int32> EdgeDirection;
+};
+
+/**
+ * Nearest-segment index over a 3D polyline, queried in XY. Segments are kept
+ * in a bounding volume hierarchy split at the median of their centers; a
+ * query descends into the nearer child first and skips every node farther
+ * than the best segment so far, so it costs about O(log n) wherever the point
+ * lies, even deep inside a large empty polygon. The closest point is then
+ * projected onto the nearest segment and its Z interpolated.
+ */
+class CARLAMESHGENERATION_API FSegmentIndex2D
+{
+public:
+
+  FSegmentIndex2D() = default;
+
+  FSegmentIndex2D(TConstArrayView<FVector3f> InVertices, bool bInClosed);
+
+  void Build(TConstArrayView<FVector3f> InVertices, bool bInClosed);
+
+  bool IsEmpty() const { return NumSegments == 0; }
+
+  /**
+   * Finds the segment closest to Point in XY and the parameter along it of
+   * the closest point. Returns false if the index is empty.
+   */
+  bool FindNearest(const FVector2f& Point, int32& OutSegment, float& OutAlpha) const;
+
+  /** Squared XY distance from Point to the polyline, or max float if it is empty. */
+  float GetDistanceSquared(const FVector2f& Point) const;
+
+  /** Z of the closest point on the polyline, interpolated along its segment. */
+  float GetZ(const FVector2f& Point) const;
+
+  /** Batched GetZ, run in parallel. OutZ must have Points.Num() elements. */
+  void GetZ(TConstArrayView<FVector2f> Points, TArrayView<float> OutZ) const;
+
+private:
+
+  struct FNode
+  {
+    FVector2f Min;
+    FVector2f Max;
+
+    // Leaves hold SegmentOrder[First, First + Count). Inner nodes have a
+    // Count of zero and their children at First and First + 1.
+    int32 First;
+    int32 Count;
+  };
+
+  void BuildNode(int32 NodeIndex, int32 Begin, int32 End, TConstArrayView<FVector2f> Centers);
+
+  TArray<FVector3f> Vertices;
+  int32 NumSegments = 0;
+
+  TArray<FNode> Nodes;
+  TArray<int32> SegmentOrder;
+};